@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+  Compares sorting a batch of equal-length arrays with sortValuesBatch() in
+  the transposed (lane) layout against calling sortValues() once per array.
+  Results are written to the standard output as JSON.
+*/
+
+#include "../src/CompiledNetwork.h"
+#include "../src/LaneLayout.h"
+#include "../src/Network.h"
+#include "Measure.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Benchmarks::measureNs;
+using sharemind::SortingNetwork::CompiledNetwork;
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::fromLaneLayout;
+using sharemind::SortingNetwork::toLaneLayout;
+
+template <typename T>
+void benchmark(char const * typeName,
+               std::size_t numInputs,
+               std::size_t batchSize,
+               bool & first)
+{
+    auto const network(Network::makeOddEvenMergeSort(numInputs));
+    CompiledNetwork const compiled(network);
+
+    std::mt19937_64 rng(numInputs * batchSize);
+    std::vector<T> input(numInputs * batchSize);
+    for (auto & value : input)
+        value = static_cast<T>(rng() % 1000000u);
+    std::vector<T> data(input.size());
+    std::vector<T> lanes(input.size());
+
+    auto const perArrayNetwork = measureNs([&]{
+        data = input;
+        for (std::size_t i = 0u; i < batchSize; ++i)
+            network.sortValues(data.data() + i * numInputs);
+    });
+    auto const perArrayCompiled = measureNs([&]{
+        data = input;
+        for (std::size_t i = 0u; i < batchSize; ++i)
+            compiled.sortValues(data.data() + i * numInputs);
+    });
+    auto const copy = measureNs([&]{ data = input; });
+    auto const transpose = measureNs([&]{
+        toLaneLayout(input.data(), batchSize, numInputs, lanes.data());
+        fromLaneLayout(lanes.data(), batchSize, numInputs, data.data());
+    });
+    auto const batch = measureNs([&]{
+        toLaneLayout(input.data(), batchSize, numInputs, lanes.data());
+        compiled.sortValuesBatch(lanes.data(), batchSize);
+    });
+    auto const batchNetwork = measureNs([&]{
+        toLaneLayout(input.data(), batchSize, numInputs, lanes.data());
+        network.sortValuesBatch(lanes.data(), batchSize);
+    });
+
+    auto const perArray = [batchSize](double ns)
+            { return ns / static_cast<double>(batchSize); };
+    std::cout << (first ? "\n" : ",\n")
+              << "    {\"type\": \"" << typeName << "\""
+              << ", \"numInputs\": " << numInputs
+              << ", \"batchSize\": " << batchSize
+              << ", \"nsPerArray\": {"
+              << "\"sortValuesNetwork\": " << perArray(perArrayNetwork - copy)
+              << ", \"sortValuesCompiled\": "
+              << perArray(perArrayCompiled - copy)
+              << ", \"sortValuesBatchNetwork\": "
+              << perArray(batchNetwork - transpose / 2.0)
+              << ", \"sortValuesBatchCompiled\": "
+              << perArray(batch - transpose / 2.0)
+              << ", \"laneTransposeBothWays\": " << perArray(transpose)
+              << "}}";
+    first = false;
+}
+
+} // anonymous namespace
+
+int main() {
+    bool first = true;
+    std::cout << "{\"benchmark\": \"batch\", \"results\": [";
+    for (std::size_t numInputs : {4u, 8u, 16u, 32u, 64u, 128u}) {
+        for (std::size_t batchSize : {256u, 4096u, 32768u}) {
+            benchmark<std::int32_t>("int32", numInputs, batchSize, first);
+            benchmark<double>("double", numInputs, batchSize, first);
+        }
+    }
+    std::cout << "\n]}" << std::endl;
+}
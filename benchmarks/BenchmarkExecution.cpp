@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+  Compares sorting with sortValues() of an odd-even merge sort network, with
+  and without a comparison function object, against std::sort() and insertion
+  sort on the same data for various element types, sizes and input
+  distributions. Results are written to the standard output as JSON.
+*/
+
+#include "../src/CompiledNetwork.h"
+#include "../src/Network.h"
+#include "Measure.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Benchmarks::measureNs;
+using sharemind::SortingNetwork::CompiledNetwork;
+using sharemind::SortingNetwork::Network;
+
+/** A large record sorted by its key only: */
+struct LargeRecord {
+    std::int64_t key;
+    unsigned char payload[120u];
+};
+
+bool operator<(LargeRecord const & lhs, LargeRecord const & rhs) noexcept
+{ return lhs.key < rhs.key; }
+
+template <typename T>
+T makeValue(std::uint64_t v) { return static_cast<T>(v); }
+
+template <>
+std::string makeValue<std::string>(std::uint64_t v) {
+    /* Use a common prefix to make comparisons less trivial: */
+    auto digits(std::to_string(v));
+    return std::string("value-") + std::string(20u - digits.size(), '0')
+           + digits;
+}
+
+template <>
+LargeRecord makeValue<LargeRecord>(std::uint64_t v) {
+    LargeRecord r;
+    r.key = static_cast<std::int64_t>(v);
+    for (auto & p : r.payload)
+        p = static_cast<unsigned char>(v);
+    return r;
+}
+
+enum class Distribution { Random, Sorted, Reversed, FewUnique };
+
+char const * distributionName(Distribution d) noexcept {
+    switch (d) {
+    case Distribution::Random: return "random";
+    case Distribution::Sorted: return "sorted";
+    case Distribution::Reversed: return "reversed";
+    case Distribution::FewUnique: return "fewUnique";
+    }
+    return "";
+}
+
+template <typename T>
+std::vector<T> makeInput(std::size_t size, Distribution d) {
+    std::mt19937_64 rng(size);
+    std::vector<std::uint64_t> keys(size);
+    for (std::size_t i = 0u; i < size; ++i) {
+        switch (d) {
+        case Distribution::Random: keys[i] = rng() % 1000000000u; break;
+        case Distribution::Sorted: keys[i] = i; break;
+        case Distribution::Reversed: keys[i] = size - i; break;
+        case Distribution::FewUnique: keys[i] = rng() % 4u; break;
+        }
+    }
+    std::vector<T> r;
+    r.reserve(size);
+    for (auto const key : keys)
+        r.emplace_back(makeValue<T>(key));
+    return r;
+}
+
+template <typename It>
+void insertionSort(It first, It last) {
+    if (first == last)
+        return;
+    for (auto it = std::next(first); it != last; ++it) {
+        auto value(std::move(*it));
+        auto pos(it);
+        for (; (pos != first) && (value < *std::prev(pos)); --pos)
+            *pos = std::move(*std::prev(pos));
+        *pos = std::move(value);
+    }
+}
+
+template <typename T>
+void benchmark(char const * typeName,
+               Network const & network,
+               CompiledNetwork const & compiled,
+               Distribution distribution,
+               bool & first)
+{
+    auto const size = network.numInputs();
+    auto const input(makeInput<T>(size, distribution));
+    auto data(input);
+    auto const less = [](T const & lhs, T const & rhs) { return lhs < rhs; };
+
+    auto const copy = measureNs([&]{ data = input; });
+    auto const sortValues = measureNs([&]{
+        data = input;
+        network.sortValues(data.data());
+    });
+    auto const sortValuesComp = measureNs([&]{
+        data = input;
+        network.sortValues(data.data(), less);
+    });
+    auto const sortValuesCompiled = measureNs([&]{
+        data = input;
+        compiled.sortValues(data.data());
+    });
+    auto const stdSort = measureNs([&]{
+        data = input;
+        std::sort(data.begin(), data.end());
+    });
+    auto const insertion = measureNs([&]{
+        data = input;
+        insertionSort(data.begin(), data.end());
+    });
+
+    auto const perElement = [size, copy](double ns)
+            { return (ns - copy) / static_cast<double>(size); };
+    std::cout << (first ? "\n" : ",\n")
+              << "    {\"type\": \"" << typeName << "\""
+              << ", \"numInputs\": " << size
+              << ", \"distribution\": \"" << distributionName(distribution)
+              << "\", \"nsPerElement\": {"
+              << "\"sortValues\": " << perElement(sortValues)
+              << ", \"sortValuesWithComparator\": "
+              << perElement(sortValuesComp)
+              << ", \"sortValuesCompiled\": " << perElement(sortValuesCompiled)
+              << ", \"stdSort\": " << perElement(stdSort)
+              << ", \"insertionSort\": " << perElement(insertion)
+              << "}}" << std::flush;
+    first = false;
+}
+
+} // anonymous namespace
+
+int main() {
+    bool first = true;
+    std::cout << "{\"benchmark\": \"execution\", \"results\": [";
+    for (std::size_t numInputs : {2u, 3u, 4u, 7u, 8u, 16u, 31u, 32u, 64u,
+                                  100u, 128u, 256u, 512u, 1000u, 1024u, 2048u,
+                                  4096u})
+    {
+        auto const network(Network::makeOddEvenMergeSort(numInputs));
+        CompiledNetwork const compiled(network);
+        for (auto const distribution : {Distribution::Random,
+                                        Distribution::Sorted,
+                                        Distribution::Reversed,
+                                        Distribution::FewUnique})
+        {
+            benchmark<std::int32_t>("int32", network, compiled, distribution,
+                                    first);
+            benchmark<std::int64_t>("int64", network, compiled, distribution,
+                                    first);
+            benchmark<double>("double", network, compiled, distribution,
+                              first);
+            benchmark<std::string>("string", network, compiled, distribution,
+                                   first);
+            benchmark<LargeRecord>("largeRecord", network, compiled,
+                                   distribution, first);
+        }
+    }
+    std::cout << "\n]}" << std::endl;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+  Measures the running time and the peak heap usage of the network generators
+  and transformations for numbers of inputs from 2 up to 2^maxLog2 (20 by
+  default, or the first command line argument). Once a single run of an
+  operation takes longer than the time limit (30 seconds by default, or the
+  second command line argument), the operation is skipped for larger numbers
+  of inputs. Results are written to the standard output as JSON.
+*/
+
+#include "../src/Network.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+/* Heap usage accounting by the replaced global allocation functions below: */
+std::size_t currentHeapBytes = 0u;
+std::size_t peakHeapBytes = 0u;
+
+constexpr std::size_t const allocationHeaderSize = alignof(std::max_align_t);
+
+void * allocate(std::size_t size) {
+    auto * const p = static_cast<char *>(
+                std::malloc(size + allocationHeaderSize));
+    if (!p)
+        throw std::bad_alloc();
+    *reinterpret_cast<std::size_t *>(p) = size;
+    currentHeapBytes += size;
+    peakHeapBytes = std::max(peakHeapBytes, currentHeapBytes);
+    return p + allocationHeaderSize;
+}
+
+void deallocate(void * ptr) noexcept {
+    if (!ptr)
+        return;
+    auto * const p = static_cast<char *>(ptr) - allocationHeaderSize;
+    currentHeapBytes -= *reinterpret_cast<std::size_t *>(p);
+    std::free(p);
+}
+
+} // anonymous namespace
+
+void * operator new(std::size_t size) { return allocate(size); }
+void * operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void * ptr) noexcept { deallocate(ptr); }
+void operator delete[](void * ptr) noexcept { deallocate(ptr); }
+void operator delete(void * ptr, std::size_t) noexcept { deallocate(ptr); }
+void operator delete[](void * ptr, std::size_t) noexcept { deallocate(ptr); }
+
+namespace {
+
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::combineBitonicMerge;
+using sharemind::SortingNetwork::combineOddEvenMerge;
+
+using Clock = std::chrono::steady_clock;
+
+struct Measurement {
+    std::size_t iterations = 0u;
+    double nsPerOperation = 0.0;
+    std::size_t peakBytes = 0u;
+    std::size_t numComparators = 0u;
+    std::size_t numStages = 0u;
+};
+
+/**
+  Runs prepare() followed by a timed operation(network) until at least 100
+  milliseconds have been spent in the operation, and records the average
+  running time, the peak heap usage of the operation on top of the heap usage
+  after prepare(), and the size of the resulting network.
+*/
+Measurement measure(std::function<void (Network &)> const & prepare,
+                    std::function<void (Network &)> const & operation)
+{
+    Measurement m;
+    std::chrono::duration<double, std::nano> elapsed(0);
+    do {
+        Network network(0u);
+        prepare(network);
+        peakHeapBytes = currentHeapBytes;
+        auto const baseline = currentHeapBytes;
+        auto const start(Clock::now());
+        operation(network);
+        elapsed += Clock::now() - start;
+        m.peakBytes = std::max(m.peakBytes, peakHeapBytes - baseline);
+        m.numComparators = network.numComparators();
+        m.numStages = network.numStages();
+        ++m.iterations;
+    } while (elapsed < std::chrono::milliseconds(100));
+    m.nsPerOperation = elapsed.count() / static_cast<double>(m.iterations);
+    return m;
+}
+
+struct Operation {
+    char const * name;
+    std::function<void (Network &, std::size_t)> prepare;
+    std::function<void (Network &, std::size_t)> operation;
+    bool skip;
+};
+
+void noPreparation(Network &, std::size_t) noexcept {}
+
+void prepareSorter(Network & network, std::size_t numInputs)
+{ network = Network::makeOddEvenMergeSort(numInputs); }
+
+/** Prepares a network in which every comparator points the wrong way: */
+void prepareInvertedSorter(Network & network, std::size_t numInputs) {
+    network = Network::makeOddEvenMergeSort(numInputs);
+    network.invert();
+}
+
+/** Prepares an uncompressed sorter with one comparator per stage: */
+void prepareUncompressedSorter(Network & network, std::size_t numInputs) {
+    auto const sorter(Network::makeOddEvenMergeSort(numInputs));
+    Network uncompressed(numInputs);
+    for (auto const & stage : sorter.stages())
+        for (auto const & comparator : stage.comparators())
+            uncompressed.composeWithEmptyStage().addComparator(comparator);
+    network = std::move(uncompressed);
+}
+
+std::vector<Operation> makeOperations() {
+    auto const half = [](std::size_t n) { return n / 2u; };
+    /* The network joined by joinWith, generated once per number of inputs
+       outside of the measured operation: */
+    auto const other(std::make_shared<Network>(0u));
+    return {
+        {"makeOddEvenMergeSort",
+         noPreparation,
+         [](Network & n, std::size_t numInputs)
+         { n = Network::makeOddEvenMergeSort(numInputs); },
+         false},
+        {"makeBitonicMergeSort",
+         noPreparation,
+         [](Network & n, std::size_t numInputs)
+         { n = Network::makeBitonicMergeSort(numInputs); },
+         false},
+        {"makePairwiseSort",
+         noPreparation,
+         [](Network & n, std::size_t numInputs)
+         { n = Network::makePairwiseSort(numInputs); },
+         false},
+        {"compress",
+         prepareUncompressedSorter,
+         [](Network & n, std::size_t) { n.compress(); },
+         false},
+        {"normalize",
+         prepareInvertedSorter,
+         [](Network & n, std::size_t) { n.normalize(); },
+         false},
+        {"canonicalize",
+         prepareUncompressedSorter,
+         [](Network & n, std::size_t) { n.canonicalize(); },
+         false},
+        {"joinWith",
+         [half, other](Network & n, std::size_t numInputs) {
+             prepareSorter(n, half(numInputs));
+             auto const numOtherInputs = numInputs - half(numInputs);
+             if (other->numInputs() != numOtherInputs)
+                 *other = Network::makeOddEvenMergeSort(numOtherInputs);
+         },
+         [other](Network & n, std::size_t) { n.joinWith(*other); },
+         false},
+        {"combineOddEvenMerge",
+         [half](Network & n, std::size_t numInputs)
+         { prepareSorter(n, half(numInputs)); },
+         [](Network & n, std::size_t) { n = combineOddEvenMerge(n, n); },
+         false},
+        {"combineBitonicMerge",
+         [half](Network & n, std::size_t numInputs)
+         { prepareSorter(n, half(numInputs)); },
+         [](Network & n, std::size_t) { n = combineBitonicMerge(n, n); },
+         false},
+        {"removeInput",
+         prepareSorter,
+         [half](Network & n, std::size_t numInputs)
+         { n.removeInput(half(numInputs)); },
+         false}
+    };
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv) {
+    unsigned const maxLog2 =
+            (argc > 1) ? static_cast<unsigned>(std::stoul(argv[1])) : 20u;
+    double const timeLimitNs =
+            ((argc > 2) ? std::stod(argv[2]) : 30.0) * 1e9;
+
+    auto operations(makeOperations());
+    bool first = true;
+    std::cout << "{\"benchmark\": \"generation\", \"results\": [";
+    for (unsigned log2 = 1u; log2 <= maxLog2; ++log2) {
+        std::size_t const numInputs = std::size_t(1u) << log2;
+        for (auto & op : operations) {
+            if (op.skip)
+                continue;
+            auto const m(measure(
+                    [&op, numInputs](Network & n) { op.prepare(n, numInputs); },
+                    [&op, numInputs](Network & n)
+                    { op.operation(n, numInputs); }));
+            op.skip = (m.nsPerOperation > timeLimitNs);
+            std::cout << (first ? "\n" : ",\n")
+                      << "    {\"operation\": \"" << op.name << "\""
+                      << ", \"numInputs\": " << numInputs
+                      << ", \"iterations\": " << m.iterations
+                      << ", \"nsPerOperation\": " << m.nsPerOperation
+                      << ", \"peakBytes\": " << m.peakBytes
+                      << ", \"numComparators\": " << m.numComparators
+                      << ", \"numStages\": " << m.numStages << "}"
+                      << std::flush;
+            first = false;
+        }
+    }
+    std::cout << "\n]}" << std::endl;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_BENCHMARKS_MEASURE_H
+#define SHAREMIND_LIBSORTNETWORK_BENCHMARKS_MEASURE_H
+
+#include <chrono>
+#include <cstddef>
+
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace Benchmarks {
+
+using Clock = std::chrono::steady_clock;
+
+/** \returns the average running time of f() in nanoseconds. */
+template <typename F>
+double measureNs(F && f) {
+    std::size_t iterations = 0u;
+    auto const start(Clock::now());
+    auto now(start);
+    do {
+        f();
+        ++iterations;
+        now = Clock::now();
+    } while (now - start < std::chrono::milliseconds(100));
+    std::chrono::duration<double, std::nano> const elapsed(now - start);
+    return elapsed.count() / static_cast<double>(iterations);
+}
+
+} /* namespace Benchmarks { */
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_BENCHMARKS_MEASURE_H */
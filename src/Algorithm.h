@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_ALGORITHM_H
+#define SHAREMIND_LIBSORTNETWORK_ALGORITHM_H
+
+
+namespace sharemind {
+namespace SortingNetwork {
+
+/** The algorithms used to generate sorting networks. */
+enum class Algorithm {
+    /** Batcher's Odd-Even-Mergesort, see Network::makeOddEvenMergeSort(). */
+    OddEvenMergeSort,
+
+    /** Batcher's Bitonic-Mergesort, see Network::makeBitonicMergeSort(). */
+    BitonicMergeSort,
+
+    /** Parberry's Pairwise sorting network, see Network::makePairwiseSort(). */
+    PairwiseSort
+};
+
+/** The properties of sorting networks to minimize, see makeBestKnown(). */
+enum class Objective {
+    /** Minimize the number of comparators, then the number of stages. */
+    Size,
+
+    /** Minimize the number of stages, then the number of comparators. */
+    Depth
+};
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_ALGORITHM_H */
@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#include "Network.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace {
+
+/*
+  The best known size-optimal sorting networks for up to 16 inputs (see Knuth,
+  The Art of Computer Programming, Vol. 3, Section 5.3.4), as the pairs of the
+  minimum and maximum lines of the comparators of each stage, followed by
+  stageEnd. The networks for up to 12 inputs are proven size-optimal, the one
+  for 16 inputs is due to Green and the one for 15 inputs is derived from it
+  by removing its topmost line.
+*/
+constexpr unsigned char const stageEnd = 0xffu;
+
+/* 2 inputs, size 1, depth 1: */
+constexpr unsigned char const network2[] = {
+    0, 1, stageEnd
+};
+
+/* 3 inputs, size 3, depth 3: */
+constexpr unsigned char const network3[] = {
+    0, 2, stageEnd,
+    0, 1, stageEnd,
+    1, 2, stageEnd
+};
+
+/* 4 inputs, size 5, depth 3: */
+constexpr unsigned char const network4[] = {
+    0, 2, 1, 3, stageEnd,
+    0, 1, 2, 3, stageEnd,
+    1, 2, stageEnd
+};
+
+/* 5 inputs, size 9, depth 5: */
+constexpr unsigned char const network5[] = {
+    0, 3, 1, 4, stageEnd,
+    0, 2, 1, 3, stageEnd,
+    0, 1, 2, 4, stageEnd,
+    1, 2, 3, 4, stageEnd,
+    2, 3, stageEnd
+};
+
+/* 6 inputs, size 12, depth 5: */
+constexpr unsigned char const network6[] = {
+    0, 5, 1, 3, 2, 4, stageEnd,
+    1, 2, 3, 4, stageEnd,
+    0, 3, 2, 5, stageEnd,
+    0, 1, 2, 3, 4, 5, stageEnd,
+    1, 2, 3, 4, stageEnd
+};
+
+/* 7 inputs, size 16, depth 6: */
+constexpr unsigned char const network7[] = {
+    0, 6, 2, 3, 4, 5, stageEnd,
+    0, 2, 1, 4, 3, 6, stageEnd,
+    0, 1, 2, 5, 3, 4, stageEnd,
+    1, 2, 4, 6, stageEnd,
+    2, 3, 4, 5, stageEnd,
+    1, 2, 3, 4, 5, 6, stageEnd
+};
+
+/* 8 inputs, size 19, depth 6: */
+constexpr unsigned char const network8[] = {
+    0, 2, 1, 3, 4, 6, 5, 7, stageEnd,
+    0, 4, 1, 5, 2, 6, 3, 7, stageEnd,
+    0, 1, 2, 3, 4, 5, 6, 7, stageEnd,
+    2, 4, 3, 5, stageEnd,
+    1, 4, 3, 6, stageEnd,
+    1, 2, 3, 4, 5, 6, stageEnd
+};
+
+/* 9 inputs, size 25, depth 7: */
+constexpr unsigned char const network9[] = {
+    0, 3, 1, 7, 2, 5, 4, 8, stageEnd,
+    0, 7, 2, 4, 3, 8, 5, 6, stageEnd,
+    0, 2, 1, 3, 4, 5, 7, 8, stageEnd,
+    1, 4, 3, 6, 5, 7, stageEnd,
+    0, 1, 2, 4, 3, 5, 6, 8, stageEnd,
+    2, 3, 4, 5, 6, 7, stageEnd,
+    1, 2, 3, 4, 5, 6, stageEnd
+};
+
+/* 10 inputs, size 29, depth 8: */
+constexpr unsigned char const network10[] = {
+    0, 8, 1, 9, 2, 7, 3, 5, 4, 6, stageEnd,
+    0, 2, 1, 4, 5, 8, 7, 9, stageEnd,
+    0, 3, 2, 4, 5, 7, 6, 9, stageEnd,
+    0, 1, 3, 6, 8, 9, stageEnd,
+    1, 5, 2, 3, 4, 8, 6, 7, stageEnd,
+    1, 2, 3, 5, 4, 6, 7, 8, stageEnd,
+    2, 3, 4, 5, 6, 7, stageEnd,
+    3, 4, 5, 6, stageEnd
+};
+
+/* 11 inputs, size 35, depth 8: */
+constexpr unsigned char const network11[] = {
+    0, 9, 1, 6, 2, 4, 3, 7, 5, 8, stageEnd,
+    0, 1, 3, 5, 4, 10, 6, 9, 7, 8, stageEnd,
+    1, 3, 2, 5, 4, 7, 8, 10, stageEnd,
+    0, 4, 1, 2, 3, 7, 5, 9, 6, 8, stageEnd,
+    0, 1, 2, 6, 4, 5, 7, 8, 9, 10, stageEnd,
+    2, 4, 3, 6, 5, 7, 8, 9, stageEnd,
+    1, 2, 3, 4, 5, 6, 7, 8, stageEnd,
+    2, 3, 4, 5, 6, 7, stageEnd
+};
+
+/* 12 inputs, size 39, depth 9: */
+constexpr unsigned char const network12[] = {
+    0, 8, 1, 7, 2, 6, 3, 11, 4, 10, 5, 9, stageEnd,
+    0, 1, 2, 5, 3, 4, 6, 9, 7, 8, 10, 11, stageEnd,
+    0, 2, 1, 6, 5, 10, 9, 11, stageEnd,
+    0, 3, 1, 2, 4, 6, 5, 7, 8, 11, 9, 10, stageEnd,
+    1, 4, 3, 5, 6, 8, 7, 10, stageEnd,
+    1, 3, 2, 5, 6, 9, 8, 10, stageEnd,
+    2, 3, 4, 5, 6, 7, 8, 9, stageEnd,
+    4, 6, 5, 7, stageEnd,
+    3, 4, 5, 6, 7, 8, stageEnd
+};
+
+/* 13 inputs, size 45, depth 10: */
+constexpr unsigned char const network13[] = {
+    0, 12, 1, 10, 2, 9, 3, 7, 5, 11, 6, 8, stageEnd,
+    1, 6, 2, 3, 4, 11, 7, 9, 8, 10, stageEnd,
+    0, 4, 1, 2, 3, 6, 7, 8, 9, 10, 11, 12, stageEnd,
+    4, 6, 5, 9, 8, 11, 10, 12, stageEnd,
+    0, 5, 3, 8, 4, 7, 6, 11, 9, 10, stageEnd,
+    0, 1, 2, 5, 6, 9, 7, 8, 10, 11, stageEnd,
+    1, 3, 2, 4, 5, 6, 9, 10, stageEnd,
+    1, 2, 3, 4, 5, 7, 6, 8, stageEnd,
+    2, 3, 4, 5, 6, 7, 8, 9, stageEnd,
+    3, 4, 5, 6, stageEnd
+};
+
+/* 14 inputs, size 51, depth 10: */
+constexpr unsigned char const network14[] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, stageEnd,
+    0, 2, 1, 3, 4, 8, 5, 9, 10, 12, 11, 13, stageEnd,
+    0, 4, 1, 2, 3, 7, 5, 8, 6, 10, 9, 13, 11, 12, stageEnd,
+    0, 6, 1, 5, 3, 9, 4, 10, 7, 13, 8, 12, stageEnd,
+    2, 10, 3, 11, 4, 6, 7, 9, stageEnd,
+    1, 3, 2, 8, 5, 11, 6, 7, 10, 12, stageEnd,
+    1, 4, 2, 6, 3, 5, 7, 11, 8, 10, 9, 12, stageEnd,
+    2, 4, 3, 6, 5, 8, 7, 10, 9, 11, stageEnd,
+    3, 4, 5, 6, 7, 8, 9, 10, stageEnd,
+    6, 7, stageEnd
+};
+
+/* 15 inputs, size 56, depth 10: */
+constexpr unsigned char const network15[] = {
+    0, 13, 1, 12, 3, 14, 4, 8, 5, 6, 7, 11, 9, 10, stageEnd,
+    0, 5, 1, 7, 2, 9, 3, 4, 6, 13, 8, 14, 11, 12, stageEnd,
+    0, 1, 2, 3, 4, 5, 6, 8, 7, 9, 10, 11, 12, 13, stageEnd,
+    0, 2, 1, 3, 4, 10, 5, 11, 6, 7, 8, 9, 12, 14, stageEnd,
+    1, 2, 3, 12, 4, 6, 5, 7, 8, 10, 9, 11, 13, 14, stageEnd,
+    1, 4, 2, 6, 5, 8, 7, 10, 9, 13, 11, 14, stageEnd,
+    2, 4, 3, 6, 9, 12, 11, 13, stageEnd,
+    3, 5, 6, 8, 7, 9, 10, 12, stageEnd,
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 12, stageEnd,
+    6, 7, 8, 9, stageEnd
+};
+
+/* 16 inputs, size 60, depth 10: */
+constexpr unsigned char const network16[] = {
+    0, 13, 1, 12, 2, 15, 3, 14, 4, 8, 5, 6, 7, 11, 9, 10, stageEnd,
+    0, 5, 1, 7, 2, 9, 3, 4, 6, 13, 8, 14, 10, 15, 11, 12, stageEnd,
+    0, 1, 2, 3, 4, 5, 6, 8, 7, 9, 10, 11, 12, 13, 14, 15, stageEnd,
+    0, 2, 1, 3, 4, 10, 5, 11, 6, 7, 8, 9, 12, 14, 13, 15, stageEnd,
+    1, 2, 3, 12, 4, 6, 5, 7, 8, 10, 9, 11, 13, 14, stageEnd,
+    1, 4, 2, 6, 5, 8, 7, 10, 9, 13, 11, 14, stageEnd,
+    2, 4, 3, 6, 9, 12, 11, 13, stageEnd,
+    3, 5, 6, 8, 7, 9, 10, 12, stageEnd,
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 12, stageEnd,
+    6, 7, 8, 9, stageEnd
+};
+
+struct TableEntry {
+    unsigned char const * data;
+    std::size_t size;
+};
+
+#define SHAREMIND_LIBSORTNETWORK_ENTRY(n) { network ## n, sizeof(network ## n) }
+constexpr TableEntry const table[] = {
+    { nullptr, 0u }, { nullptr, 0u },
+    SHAREMIND_LIBSORTNETWORK_ENTRY(2),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(3),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(4),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(5),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(6),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(7),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(8),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(9),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(10),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(11),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(12),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(13),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(14),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(15),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(16)
+};
+#undef SHAREMIND_LIBSORTNETWORK_ENTRY
+
+/*
+  The best known depth-optimal sorting networks for the numbers of inputs for
+  which no network above is depth-optimal. The optimal depths are proven by
+  Bundala and Zavodny (Optimal Sorting Networks, 2014). The networks for 10
+  and 16 inputs are taken from Knuth (see above), the latter is due to Van
+  Voorhis. The ones for 13 to 15 inputs are derived from it by removing its
+  topmost lines and the comparators which never swap after this. The
+  network for 12 inputs was found by a randomized search and has as many
+  comparators as the best known network of depth 8.
+*/
+
+/* 10 inputs, size 31, depth 7: */
+constexpr unsigned char const depthNetwork10[] = {
+    0, 1, 2, 5, 3, 6, 4, 7, 8, 9, stageEnd,
+    0, 6, 1, 8, 2, 4, 3, 9, 5, 7, stageEnd,
+    0, 2, 1, 3, 4, 5, 6, 8, 7, 9, stageEnd,
+    0, 1, 2, 7, 3, 5, 4, 6, 8, 9, stageEnd,
+    1, 2, 3, 4, 5, 6, 7, 8, stageEnd,
+    1, 3, 2, 4, 5, 7, 6, 8, stageEnd,
+    2, 3, 4, 5, 6, 7, stageEnd
+};
+
+/* 12 inputs, size 40, depth 8: */
+constexpr unsigned char const depthNetwork12[] = {
+    0, 11, 1, 10, 2, 9, 3, 8, 4, 7, 5, 6, stageEnd,
+    0, 4, 1, 3, 2, 5, 6, 9, 7, 11, 8, 10, stageEnd,
+    1, 2, 3, 6, 4, 7, 5, 8, 9, 10, stageEnd,
+    0, 3, 2, 5, 4, 6, 7, 9, 8, 11, stageEnd,
+    0, 1, 2, 4, 3, 8, 5, 7, 6, 9, 10, 11, stageEnd,
+    1, 2, 3, 5, 4, 7, 6, 8, 9, 10, stageEnd,
+    2, 3, 4, 5, 6, 7, 8, 9, stageEnd,
+    3, 4, 5, 6, 7, 8, stageEnd
+};
+
+/* 13 inputs, size 47, depth 9: */
+constexpr unsigned char const depthNetwork13[] = {
+    0, 5, 1, 4, 2, 12, 6, 7, 8, 9, stageEnd,
+    0, 2, 1, 10, 3, 6, 4, 7, 8, 11, 9, 12, stageEnd,
+    0, 8, 1, 3, 2, 11, 5, 9, 6, 10, 7, 12, stageEnd,
+    0, 1, 2, 4, 3, 8, 5, 6, 7, 11, 9, 10, stageEnd,
+    1, 3, 2, 5, 4, 8, 6, 9, 10, 12, stageEnd,
+    1, 2, 3, 5, 4, 11, 6, 8, 7, 9, stageEnd,
+    2, 3, 4, 5, 6, 7, 8, 9, 10, 11, stageEnd,
+    4, 6, 5, 7, 8, 10, 9, 11, stageEnd,
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 12, stageEnd
+};
+
+/* 14 inputs, size 52, depth 9: */
+constexpr unsigned char const depthNetwork14[] = {
+    0, 5, 1, 4, 2, 12, 3, 13, 6, 7, 8, 9, stageEnd,
+    0, 2, 1, 10, 3, 6, 4, 7, 8, 11, 9, 12, stageEnd,
+    0, 8, 1, 3, 2, 11, 4, 13, 5, 9, 6, 10, 7, 12, stageEnd,
+    0, 1, 2, 4, 3, 8, 5, 6, 9, 10, 11, 13, stageEnd,
+    1, 3, 2, 5, 4, 8, 6, 9, 7, 11, 10, 13, stageEnd,
+    1, 2, 3, 5, 4, 11, 6, 8, 7, 9, 10, 12, stageEnd,
+    2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, stageEnd,
+    4, 6, 5, 7, 8, 10, 9, 11, stageEnd,
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 12, stageEnd
+};
+
+/* 15 inputs, size 57, depth 9: */
+constexpr unsigned char const depthNetwork15[] = {
+    0, 5, 1, 4, 2, 12, 3, 13, 6, 7, 8, 9, 11, 14, stageEnd,
+    0, 2, 1, 10, 3, 6, 4, 7, 5, 14, 8, 11, 9, 12, stageEnd,
+    0, 8, 1, 3, 2, 11, 4, 13, 5, 9, 6, 10, 12, 14, stageEnd,
+    0, 1, 2, 4, 3, 8, 5, 6, 7, 12, 9, 10, 11, 13, stageEnd,
+    1, 3, 2, 5, 4, 8, 6, 9, 7, 11, 10, 13, 12, 14, stageEnd,
+    1, 2, 3, 5, 4, 11, 6, 8, 7, 9, 10, 12, 13, 14, stageEnd,
+    2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, stageEnd,
+    4, 6, 5, 7, 8, 10, 9, 11, stageEnd,
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 12, stageEnd
+};
+
+/* 16 inputs, size 61, depth 9: */
+constexpr unsigned char const depthNetwork16[] = {
+    0, 5, 1, 4, 2, 12, 3, 13, 6, 7, 8, 9, 10, 15, 11, 14, stageEnd,
+    0, 2, 1, 10, 3, 6, 4, 7, 5, 14, 8, 11, 9, 12, 13, 15, stageEnd,
+    0, 8, 1, 3, 2, 11, 4, 13, 5, 9, 6, 10, 7, 15, 12, 14, stageEnd,
+    0, 1, 2, 4, 3, 8, 5, 6, 7, 12, 9, 10, 11, 13, 14, 15, stageEnd,
+    1, 3, 2, 5, 4, 8, 6, 9, 7, 11, 10, 13, 12, 14, stageEnd,
+    1, 2, 3, 5, 4, 11, 6, 8, 7, 9, 10, 12, 13, 14, stageEnd,
+    2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, stageEnd,
+    4, 6, 5, 7, 8, 10, 9, 11, stageEnd,
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 12, stageEnd
+};
+
+#define SHAREMIND_LIBSORTNETWORK_ENTRY(n) \
+    { depthNetwork ## n, sizeof(depthNetwork ## n) }
+constexpr TableEntry const depthTable[] = {
+    { nullptr, 0u }, { nullptr, 0u }, { nullptr, 0u }, { nullptr, 0u },
+    { nullptr, 0u }, { nullptr, 0u }, { nullptr, 0u }, { nullptr, 0u },
+    { nullptr, 0u }, { nullptr, 0u },
+    SHAREMIND_LIBSORTNETWORK_ENTRY(10),
+    { nullptr, 0u },
+    SHAREMIND_LIBSORTNETWORK_ENTRY(12),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(13),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(14),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(15),
+    SHAREMIND_LIBSORTNETWORK_ENTRY(16)
+};
+#undef SHAREMIND_LIBSORTNETWORK_ENTRY
+
+constexpr std::size_t const tableSize = sizeof(table) / sizeof(table[0u]);
+static_assert(sizeof(depthTable) == sizeof(table), "");
+
+/** The largest number of inputs to derive networks for by merging: */
+constexpr std::size_t const maxDerivedInputs = 32u;
+
+Network makeFromTable(TableEntry const & entry, std::size_t numInputs) {
+    Network network(numInputs);
+    Stage::Comparators comparators;
+    for (std::size_t i = 0u; i < entry.size; ++i) {
+        if (entry.data[i] == stageEnd) {
+            network.composeWith(Stage(std::move(comparators)));
+            comparators = Stage::Comparators();
+        } else {
+            comparators.emplace_back(entry.data[i], entry.data[i + 1u]);
+            ++i;
+        }
+    }
+    return network;
+}
+
+std::pair<std::size_t, std::size_t> cost(Network const & network,
+                                         Objective objective) noexcept
+{
+    return (objective == Objective::Size)
+           ? std::make_pair(network.numComparators(), network.numStages())
+           : std::make_pair(network.numStages(), network.numComparators());
+}
+
+void keepBetter(Network & best, Network && candidate, Objective objective) {
+    if (cost(candidate, objective) < cost(best, objective))
+        best = std::move(candidate);
+}
+
+/** \returns the best generated or tabulated network. */
+Network makeBestBasic(std::size_t numInputs, Objective objective) {
+    auto r(Network::makeOddEvenMergeSort(numInputs));
+    keepBetter(r, Network::makeBitonicMergeSort(numInputs), objective);
+    keepBetter(r, Network::makePairwiseSort(numInputs), objective);
+    if (numInputs < tableSize) {
+        keepBetter(r, makeFromTable(table[numInputs], numInputs), objective);
+        if (depthTable[numInputs].data)
+            keepBetter(r,
+                       makeFromTable(depthTable[numInputs], numInputs),
+                       objective);
+    }
+    return r;
+}
+
+} // anonymous namespace
+
+Network Network::makeBestKnown(std::size_t numInputs, Objective objective) {
+    if ((numInputs < tableSize) || (numInputs > maxDerivedInputs))
+        return makeBestBasic(numInputs, objective);
+
+    // Derive the networks bottom-up, each from the best ones for fewer inputs:
+    std::vector<Network> best;
+    best.reserve(numInputs + 1u);
+    for (std::size_t n = 0u; n <= numInputs; ++n) {
+        auto r(makeBestBasic(n, objective));
+        if (n >= tableSize) {
+            for (std::size_t i = 1u; i < n; ++i)
+                keepBetter(r,
+                           combineOddEvenMerge(best[i], best[n - i]),
+                           objective);
+        }
+        best.emplace_back(std::move(r));
+    }
+    return std::move(best.back());
+}
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#include "CompiledNetwork.h"
+
+#include <limits>
+#include <stdexcept>
+
+
+namespace sharemind {
+namespace SortingNetwork {
+
+CompiledNetwork::CompiledNetwork(Network const & network)
+    : m_numInputs(network.numInputs())
+    , m_numStages(network.numStages())
+    , m_numComparators(network.numComparators())
+{
+    auto const maxIndex = std::numeric_limits<Index>::max();
+    if ((m_numInputs > maxIndex)
+        || (m_numComparators > maxIndex)
+        || ((std::numeric_limits<std::size_t>::max() - (m_numStages + 1u)) / 2u
+            < m_numComparators))
+        throw std::length_error("Comparator network exceeds implementation "
+                                "limits of compiled networks!");
+
+    m_data.resize((m_numStages + 1u) + 2u * m_numComparators);
+    auto offsets(m_data.data());
+    auto mins(offsets + (m_numStages + 1u));
+    auto maxs(mins + m_numComparators);
+
+    std::size_t i = 0u;
+    for (auto const & stage : network.stages()) {
+        *offsets++ = static_cast<Index>(i);
+        for (auto const & c : stage.comparators()) {
+            mins[i] = static_cast<Index>(c.min());
+            maxs[i] = static_cast<Index>(c.max());
+            ++i;
+        }
+    }
+    assert(i == m_numComparators);
+    *offsets = static_cast<Index>(i);
+}
+
+CompiledNetwork::CompiledNetwork(CompiledNetwork &&) noexcept = default;
+CompiledNetwork::CompiledNetwork(CompiledNetwork const &) = default;
+
+CompiledNetwork & CompiledNetwork::operator=(CompiledNetwork &&) noexcept
+        = default;
+CompiledNetwork & CompiledNetwork::operator=(CompiledNetwork const &) = default;
+
+CompiledNetwork::~CompiledNetwork() noexcept = default;
+
+void CompiledNetwork::swap(CompiledNetwork & other) noexcept {
+    static_assert(noexcept(std::swap(m_data, other.m_data)), "");
+    std::swap(m_numInputs, other.m_numInputs);
+    std::swap(m_numStages, other.m_numStages);
+    std::swap(m_numComparators, other.m_numComparators);
+    std::swap(m_data, other.m_data);
+}
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
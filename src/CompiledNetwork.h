@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_COMPILEDNETWORK_H
+#define SHAREMIND_LIBSORTNETWORK_COMPILEDNETWORK_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <sharemind/Concepts.h>
+#include <sharemind/Iterator.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Exchange.h"
+#include "Network.h"
+
+
+namespace sharemind {
+namespace SortingNetwork {
+
+/**
+  An immutable flat execution form of a comparator network. All stages are
+  stored in a single contiguous buffer as a structure of arrays: a table of
+  stage offsets followed by an array of 32-bit indexes of the minimum lines and
+  an array of 32-bit indexes of the maximum lines of all comparators.
+*/
+class CompiledNetwork {
+
+public: /* Types: */
+
+    using Index = std::uint32_t;
+
+public: /* Methods: */
+
+    /**
+      Compiles the given comparator network.
+      \param[in] network The network to compile.
+      \throws std::length_error if the number of inputs or comparators of the
+                                network exceeds implementation limits.
+    */
+    explicit CompiledNetwork(Network const & network);
+
+    CompiledNetwork(CompiledNetwork &&) noexcept;
+    CompiledNetwork(CompiledNetwork const &);
+
+    CompiledNetwork & operator=(CompiledNetwork &&) noexcept;
+    CompiledNetwork & operator=(CompiledNetwork const &);
+
+    ~CompiledNetwork() noexcept;
+
+    std::size_t numInputs() const noexcept { return m_numInputs; }
+
+    std::size_t numStages() const noexcept { return m_numStages; }
+
+    /** \returns the total amount of comparators in this network. */
+    std::size_t numComparators() const noexcept { return m_numComparators; }
+
+    /** \returns the number of comparators for a given stage in this network. */
+    std::size_t numComparators(std::size_t stageIndex) const noexcept {
+        assert(stageIndex < m_numStages);
+        return stageOffsets()[stageIndex + 1u] - stageOffsets()[stageIndex];
+    }
+
+    /**
+      \returns a pointer to the table of numStages() + 1 stage offsets. The
+               comparators of the i-th stage are the comparators with indexes
+               in the range [stageOffsets()[i], stageOffsets()[i + 1]).
+    */
+    Index const * stageOffsets() const noexcept { return m_data.data(); }
+
+    /** \returns a pointer to the minimum line indexes of all comparators. */
+    Index const * minIndexes() const noexcept
+    { return m_data.data() + (m_numStages + 1u); }
+
+    /** \returns a pointer to the maximum line indexes of all comparators. */
+    Index const * maxIndexes() const noexcept
+    { return minIndexes() + m_numComparators; }
+
+    /**
+      Applies this comparator network to the given range of values.
+      \param[in] first Iterator to the first value to sort.
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network.
+     */
+    template <typename It,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type),
+                    Swappable(typename std::iterator_traits<It>::value_type))>
+    void sortValues(It first) const {
+        auto const mins = minIndexes();
+        auto const maxs = maxIndexes();
+        for (std::size_t i = 0u; i < m_numComparators; ++i) {
+            auto & minValue = first[mins[i]];
+            auto & maxValue = first[maxs[i]];
+            if (maxValue < minValue)
+                std::swap(minValue, maxValue);
+        }
+    }
+
+    /**
+      \{
+      Applies this comparator network to the given array of arithmetic values.
+      Each stage is processed in chunks of comparators using vectorized
+      gather, compare, blend and scatter operations if supported by the CPU
+      (AVX2 or AVX-512F, detected at runtime), otherwise the generic
+      sortValues() template above is used. The results are identical to those
+      of the generic template.
+      \param[in] first Pointer to the first value to sort.
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network.
+    */
+    void sortValues(std::int32_t * first) const;
+    void sortValues(std::uint32_t * first) const;
+    void sortValues(std::int64_t * first) const;
+    void sortValues(std::uint64_t * first) const;
+    void sortValues(float * first) const;
+    void sortValues(double * first) const;
+    /** \} */
+
+    /**
+      Applies this comparator network to the given range of values.
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network.
+      \param[in] first Iterator to the first value to sort.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+     */
+    template <typename It,
+              typename Comp,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    Swappable(typename std::iterator_traits<It>::value_type),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValues(It first, Comp comp) const
+    { sortValues<It, Comp &>(first, comp, BranchingExchange()); }
+
+    /**
+      Applies this comparator network to the given range of values using the
+      given exchange policy and operator<() for comparisons.
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network.
+      \param[in] first Iterator to the first value to sort.
+      \param[in] exchange The exchange policy (see Exchange.h), callable as
+                          exchange(first[i], first[j], doSwap) for any valid i
+                          and j, which must swap its first two arguments if and
+                          only if doSwap is true.
+     */
+    template <typename It,
+              typename Exchange,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type)),
+              typename std::enable_if<
+                    Detail::IsExchangePolicy<
+                            Exchange,
+                            typename std::iterator_traits<It>::value_type
+                    >::value,
+                    int>::type = 0>
+    void sortValues(It first, Exchange exchange) const {
+        using T = typename std::iterator_traits<It>::value_type;
+        auto less = [](T const & a, T const & b) { return a < b; };
+        sortValues<It, decltype(less) &, Exchange &>(first, less, exchange);
+    }
+
+    /**
+      Applies this comparator network to the given range of values using the
+      given exchange policy.
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network.
+      \param[in] first Iterator to the first value to sort.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+      \param[in] exchange The exchange policy (see Exchange.h), callable as
+                          exchange(first[i], first[j], doSwap) for any valid i
+                          and j, which must swap its first two arguments if and
+                          only if doSwap is true.
+     */
+    template <typename It,
+              typename Comp,
+              typename Exchange,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValues(It first, Comp comp, Exchange exchange) const {
+        auto const mins = minIndexes();
+        auto const maxs = maxIndexes();
+        for (std::size_t i = 0u; i < m_numComparators; ++i) {
+            auto & minValue = first[mins[i]];
+            auto & maxValue = first[maxs[i]];
+            exchange(minValue, maxValue, comp(maxValue, minValue));
+        }
+    }
+
+    /**
+      Applies this comparator network to a batch of equal-length arrays stored
+      in a transposed (lane) layout, i.e. the j-th value of the i-th array is
+      stored at first[j * batchSize + i] (see toLaneLayout()). Each comparator
+      is applied to all arrays at once as a branch-free selection of the
+      minimum and maximum over the batchSize lanes of its two lines, which
+      compilers vectorize for arithmetic types.
+      \param[in] first Iterator to the first value of the batch.
+      \param[in] batchSize The number of arrays in the batch.
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network times batchSize.
+     */
+    template <typename It,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValuesBatch(It first, std::size_t batchSize) const {
+        using D = typename std::iterator_traits<It>::difference_type;
+        auto const mins = minIndexes();
+        auto const maxs = maxIndexes();
+        for (std::size_t c = 0u; c < m_numComparators; ++c) {
+            auto const minLine(first + static_cast<D>(mins[c] * batchSize));
+            auto const maxLine(first + static_cast<D>(maxs[c] * batchSize));
+            for (std::size_t i = 0u; i < batchSize; ++i) {
+                auto const minValue(minLine[static_cast<D>(i)]);
+                auto const maxValue(maxLine[static_cast<D>(i)]);
+                bool const doSwap = maxValue < minValue;
+                auto const newMinValue(doSwap ? maxValue : minValue);
+                auto const newMaxValue(doSwap ? minValue : maxValue);
+                minLine[static_cast<D>(i)] = newMinValue;
+                maxLine[static_cast<D>(i)] = newMaxValue;
+            }
+        }
+    }
+
+    /**
+      Applies this comparator network to a batch of equal-length arrays stored
+      in a transposed (lane) layout, i.e. the j-th value of the i-th array is
+      stored at first[j * batchSize + i] (see toLaneLayout()).
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network times batchSize.
+      \param[in] first Iterator to the first value of the batch.
+      \param[in] batchSize The number of arrays in the batch.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+     */
+    template <typename It,
+              typename Comp,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValuesBatch(It first, std::size_t batchSize, Comp comp) const {
+        using D = typename std::iterator_traits<It>::difference_type;
+        auto const mins = minIndexes();
+        auto const maxs = maxIndexes();
+        for (std::size_t c = 0u; c < m_numComparators; ++c) {
+            auto const minLine(first + static_cast<D>(mins[c] * batchSize));
+            auto const maxLine(first + static_cast<D>(maxs[c] * batchSize));
+            for (std::size_t i = 0u; i < batchSize; ++i) {
+                auto const minValue(minLine[static_cast<D>(i)]);
+                auto const maxValue(maxLine[static_cast<D>(i)]);
+                bool const doSwap = comp(maxValue, minValue);
+                auto const newMinValue(doSwap ? maxValue : minValue);
+                auto const newMaxValue(doSwap ? minValue : maxValue);
+                minLine[static_cast<D>(i)] = newMinValue;
+                maxLine[static_cast<D>(i)] = newMaxValue;
+            }
+        }
+    }
+
+    /**
+      Executes this network stage by stage via a user-provided stage executor.
+      For each stage, the executor is called with pointers to the contiguous
+      arrays of the minimum and maximum line indexes of the comparators of that
+      stage, and the number of comparators in the stage. No copies of the
+      index arrays are made. The executor is called with the same arguments as
+      by Network::executeStages() on the network this was compiled from.
+      \param[in] executor The stage executor, callable as
+                          executor(Index const * minIndexes,
+                                   Index const * maxIndexes,
+                                   std::size_t numComparators).
+    */
+    template <typename StageExecutor>
+    void executeStages(StageExecutor && executor) const {
+        auto const offsets = stageOffsets();
+        auto const mins = minIndexes();
+        auto const maxs = maxIndexes();
+        for (std::size_t i = 0u; i < m_numStages; ++i) {
+            auto const offset = offsets[i];
+            executor(mins + offset,
+                     maxs + offset,
+                     static_cast<std::size_t>(offsets[i + 1u] - offset));
+        }
+    }
+
+    void swap(CompiledNetwork & other) noexcept;
+
+private: /* Fields: */
+
+    /** Number of inputs of the comparator network: */
+    std::size_t m_numInputs;
+
+    /** Number of stages of the comparator network: */
+    std::size_t m_numStages;
+
+    /** Number of comparators of the comparator network: */
+    std::size_t m_numComparators;
+
+    /** The stage offsets, minimum line indexes and maximum line indexes: */
+    std::vector<Index> m_data;
+
+};
+
+namespace Detail {
+
+/** The instruction sets of the vectorized CompiledNetwork::sortValues(): */
+enum class KernelIsa { Generic, Avx2, Avx512 };
+
+/** \returns the best instruction set supported by the CPU. */
+KernelIsa supportedKernelIsa() noexcept;
+
+/**
+  Limits the vectorized CompiledNetwork::sortValues() to the given instruction
+  set, e.g. to test the AVX2 kernels on CPUs supporting AVX-512F. Instruction
+  sets not supported by the CPU are never used regardless of this limit. This
+  is meant for tests and benchmarks. Sorting concurrently with a call to this
+  function is safe, but may use either instruction set.
+  \param[in] isa The best instruction set to use.
+*/
+void setMaxKernelIsa(KernelIsa isa) noexcept;
+
+} /* namespace Detail { */
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_COMPILEDNETWORK_H */
@@ -0,0 +1,462 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#include "CompiledNetwork.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#if (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define SHAREMIND_LIBSORTNETWORK_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace {
+
+#ifdef SHAREMIND_LIBSORTNETWORK_X86_KERNELS
+
+#define SHAREMIND_AVX2 __attribute__((target("avx2")))
+#define SHAREMIND_AVX512 __attribute__((target("avx512f")))
+#define SHAREMIND_LIBSORTNETWORK_ALWAYS_INLINE __attribute__((always_inline))
+
+/*
+  Every kernel loads the values on the minimum and maximum lines of a chunk of
+  independent comparators of a stage, computes the swap mask (maxValue <
+  minValue, false for unordered floating-point values, just like in the
+  generic template), blends and writes the values back. Since the comparators
+  of a stage never share lines, gathering and scattering whole chunks is safe.
+*/
+
+using Index = CompiledNetwork::Index;
+
+template <typename T>
+inline void scalarExchange(T * first,
+                           Index const minIndex,
+                           Index const maxIndex) noexcept
+{
+    auto & minValue = first[minIndex];
+    auto & maxValue = first[maxIndex];
+    if (maxValue < minValue) {
+        auto const tmp = minValue;
+        minValue = maxValue;
+        maxValue = tmp;
+    }
+}
+
+/* Always inlined, so that the wrappers below are compiled for their targets: */
+template <typename Ops>
+SHAREMIND_LIBSORTNETWORK_ALWAYS_INLINE
+inline void run_(CompiledNetwork const & network,
+                 typename Ops::Value * first) noexcept
+{
+    constexpr std::size_t width = Ops::width;
+    auto const offsets = network.stageOffsets();
+    auto const mins = network.minIndexes();
+    auto const maxs = network.maxIndexes();
+    for (std::size_t s = 0u; s < network.numStages(); ++s) {
+        std::size_t i = offsets[s];
+        std::size_t const end = offsets[s + 1u];
+        for (; i + width <= end; i += width)
+            Ops::exchange(first, mins + i, maxs + i);
+        for (; i < end; ++i)
+            scalarExchange(first, mins[i], maxs[i]);
+    }
+}
+
+template <typename Ops>
+SHAREMIND_AVX2 void runAvx2(CompiledNetwork const & network,
+                            typename Ops::Value * first) noexcept
+{ run_<Ops>(network, first); }
+
+template <typename Ops>
+SHAREMIND_AVX512 void runAvx512(CompiledNetwork const & network,
+                                typename Ops::Value * first) noexcept
+{ run_<Ops>(network, first); }
+
+/* AVX2 kernels. AVX2 has gathers, but no scatters: */
+
+template <typename T, std::uint32_t Bias>
+struct Avx2Int32Ops {
+    using Value = T;
+    static constexpr std::size_t width = 8u;
+
+    SHAREMIND_AVX2 static void exchange(T * first,
+                                        Index const * mins,
+                                        Index const * maxs) noexcept
+    {
+        auto const minIdx(_mm256_loadu_si256(
+                              reinterpret_cast<__m256i const *>(mins)));
+        auto const maxIdx(_mm256_loadu_si256(
+                              reinterpret_cast<__m256i const *>(maxs)));
+        auto const base(reinterpret_cast<int const *>(first));
+        auto const a(_mm256_i32gather_epi32(base, minIdx, 4));
+        auto const b(_mm256_i32gather_epi32(base, maxIdx, 4));
+        auto const bias(_mm256_set1_epi32(static_cast<int>(Bias)));
+        auto const swap(_mm256_cmpgt_epi32(_mm256_xor_si256(a, bias),
+                                           _mm256_xor_si256(b, bias)));
+        alignas(32) T lo[width];
+        alignas(32) T hi[width];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lo),
+                           _mm256_blendv_epi8(a, b, swap));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(hi),
+                           _mm256_blendv_epi8(b, a, swap));
+        for (std::size_t k = 0u; k < width; ++k) {
+            first[mins[k]] = lo[k];
+            first[maxs[k]] = hi[k];
+        }
+    }
+};
+
+template <typename T, std::uint64_t Bias>
+struct Avx2Int64Ops {
+    using Value = T;
+    static constexpr std::size_t width = 4u;
+
+    SHAREMIND_AVX2 static void exchange(T * first,
+                                        Index const * mins,
+                                        Index const * maxs) noexcept
+    {
+        auto const minIdx(_mm_loadu_si128(
+                              reinterpret_cast<__m128i const *>(mins)));
+        auto const maxIdx(_mm_loadu_si128(
+                              reinterpret_cast<__m128i const *>(maxs)));
+        auto const base(reinterpret_cast<long long const *>(first));
+        auto const a(_mm256_i32gather_epi64(base, minIdx, 8));
+        auto const b(_mm256_i32gather_epi64(base, maxIdx, 8));
+        auto const bias(_mm256_set1_epi64x(static_cast<long long>(Bias)));
+        auto const swap(_mm256_cmpgt_epi64(_mm256_xor_si256(a, bias),
+                                           _mm256_xor_si256(b, bias)));
+        alignas(32) T lo[width];
+        alignas(32) T hi[width];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lo),
+                           _mm256_blendv_epi8(a, b, swap));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(hi),
+                           _mm256_blendv_epi8(b, a, swap));
+        for (std::size_t k = 0u; k < width; ++k) {
+            first[mins[k]] = lo[k];
+            first[maxs[k]] = hi[k];
+        }
+    }
+};
+
+struct Avx2FloatOps {
+    using Value = float;
+    static constexpr std::size_t width = 8u;
+
+    SHAREMIND_AVX2 static void exchange(float * first,
+                                        Index const * mins,
+                                        Index const * maxs) noexcept
+    {
+        auto const minIdx(_mm256_loadu_si256(
+                              reinterpret_cast<__m256i const *>(mins)));
+        auto const maxIdx(_mm256_loadu_si256(
+                              reinterpret_cast<__m256i const *>(maxs)));
+        auto const a(_mm256_i32gather_ps(first, minIdx, 4));
+        auto const b(_mm256_i32gather_ps(first, maxIdx, 4));
+        auto const swap(_mm256_cmp_ps(b, a, _CMP_LT_OQ));
+        alignas(32) float lo[width];
+        alignas(32) float hi[width];
+        _mm256_store_ps(lo, _mm256_blendv_ps(a, b, swap));
+        _mm256_store_ps(hi, _mm256_blendv_ps(b, a, swap));
+        for (std::size_t k = 0u; k < width; ++k) {
+            first[mins[k]] = lo[k];
+            first[maxs[k]] = hi[k];
+        }
+    }
+};
+
+struct Avx2DoubleOps {
+    using Value = double;
+    static constexpr std::size_t width = 4u;
+
+    SHAREMIND_AVX2 static void exchange(double * first,
+                                        Index const * mins,
+                                        Index const * maxs) noexcept
+    {
+        auto const minIdx(_mm_loadu_si128(
+                              reinterpret_cast<__m128i const *>(mins)));
+        auto const maxIdx(_mm_loadu_si128(
+                              reinterpret_cast<__m128i const *>(maxs)));
+        auto const all(_mm256_castsi256_pd(_mm256_set1_epi64x(-1)));
+        auto const a(_mm256_mask_i32gather_pd(
+                         _mm256_setzero_pd(), first, minIdx, all, 8));
+        auto const b(_mm256_mask_i32gather_pd(
+                         _mm256_setzero_pd(), first, maxIdx, all, 8));
+        auto const swap(_mm256_cmp_pd(b, a, _CMP_LT_OQ));
+        alignas(32) double lo[width];
+        alignas(32) double hi[width];
+        _mm256_store_pd(lo, _mm256_blendv_pd(a, b, swap));
+        _mm256_store_pd(hi, _mm256_blendv_pd(b, a, swap));
+        for (std::size_t k = 0u; k < width; ++k) {
+            first[mins[k]] = lo[k];
+            first[maxs[k]] = hi[k];
+        }
+    }
+};
+
+/* AVX-512F kernels, with native scatters: */
+
+template <typename T, bool IsSigned>
+struct Avx512Int32Ops {
+    using Value = T;
+    static constexpr std::size_t width = 16u;
+
+    SHAREMIND_AVX512 static void exchange(T * first,
+                                          Index const * mins,
+                                          Index const * maxs) noexcept
+    {
+        auto const minIdx(_mm512_loadu_si512(mins));
+        auto const maxIdx(_mm512_loadu_si512(maxs));
+        __mmask16 const all(0xffffu);
+        auto const a(_mm512_mask_i32gather_epi32(
+                         _mm512_setzero_si512(), all, minIdx, first, 4));
+        auto const b(_mm512_mask_i32gather_epi32(
+                         _mm512_setzero_si512(), all, maxIdx, first, 4));
+        auto const swap(IsSigned
+                        ? _mm512_cmplt_epi32_mask(b, a)
+                        : _mm512_cmplt_epu32_mask(b, a));
+        _mm512_i32scatter_epi32(first,
+                                minIdx,
+                                _mm512_mask_blend_epi32(swap, a, b),
+                                4);
+        _mm512_i32scatter_epi32(first,
+                                maxIdx,
+                                _mm512_mask_blend_epi32(swap, b, a),
+                                4);
+    }
+};
+
+template <typename T, bool IsSigned>
+struct Avx512Int64Ops {
+    using Value = T;
+    static constexpr std::size_t width = 8u;
+
+    SHAREMIND_AVX512 static void exchange(T * first,
+                                          Index const * mins,
+                                          Index const * maxs) noexcept
+    {
+        auto const minIdx(_mm256_loadu_si256(
+                              reinterpret_cast<__m256i const *>(mins)));
+        auto const maxIdx(_mm256_loadu_si256(
+                              reinterpret_cast<__m256i const *>(maxs)));
+        __mmask8 const all(0xffu);
+        auto const a(_mm512_mask_i32gather_epi64(
+                         _mm512_setzero_si512(), all, minIdx, first, 8));
+        auto const b(_mm512_mask_i32gather_epi64(
+                         _mm512_setzero_si512(), all, maxIdx, first, 8));
+        auto const swap(IsSigned
+                        ? _mm512_cmplt_epi64_mask(b, a)
+                        : _mm512_cmplt_epu64_mask(b, a));
+        _mm512_i32scatter_epi64(first,
+                                minIdx,
+                                _mm512_mask_blend_epi64(swap, a, b),
+                                8);
+        _mm512_i32scatter_epi64(first,
+                                maxIdx,
+                                _mm512_mask_blend_epi64(swap, b, a),
+                                8);
+    }
+};
+
+struct Avx512FloatOps {
+    using Value = float;
+    static constexpr std::size_t width = 16u;
+
+    SHAREMIND_AVX512 static void exchange(float * first,
+                                          Index const * mins,
+                                          Index const * maxs) noexcept
+    {
+        auto const minIdx(_mm512_loadu_si512(mins));
+        auto const maxIdx(_mm512_loadu_si512(maxs));
+        __mmask16 const all(0xffffu);
+        auto const a(_mm512_mask_i32gather_ps(
+                         _mm512_setzero_ps(), all, minIdx, first, 4));
+        auto const b(_mm512_mask_i32gather_ps(
+                         _mm512_setzero_ps(), all, maxIdx, first, 4));
+        auto const swap(_mm512_cmp_ps_mask(b, a, _CMP_LT_OQ));
+        _mm512_i32scatter_ps(first, minIdx, _mm512_mask_blend_ps(swap, a, b), 4);
+        _mm512_i32scatter_ps(first, maxIdx, _mm512_mask_blend_ps(swap, b, a), 4);
+    }
+};
+
+struct Avx512DoubleOps {
+    using Value = double;
+    static constexpr std::size_t width = 8u;
+
+    SHAREMIND_AVX512 static void exchange(double * first,
+                                          Index const * mins,
+                                          Index const * maxs) noexcept
+    {
+        auto const minIdx(_mm256_loadu_si256(
+                              reinterpret_cast<__m256i const *>(mins)));
+        auto const maxIdx(_mm256_loadu_si256(
+                              reinterpret_cast<__m256i const *>(maxs)));
+        __mmask8 const all(0xffu);
+        auto const a(_mm512_mask_i32gather_pd(
+                         _mm512_setzero_pd(), all, minIdx, first, 8));
+        auto const b(_mm512_mask_i32gather_pd(
+                         _mm512_setzero_pd(), all, maxIdx, first, 8));
+        auto const swap(_mm512_cmp_pd_mask(b, a, _CMP_LT_OQ));
+        _mm512_i32scatter_pd(first, minIdx, _mm512_mask_blend_pd(swap, a, b), 8);
+        _mm512_i32scatter_pd(first, maxIdx, _mm512_mask_blend_pd(swap, b, a), 8);
+    }
+};
+
+#undef SHAREMIND_LIBSORTNETWORK_ALWAYS_INLINE
+#undef SHAREMIND_AVX512
+#undef SHAREMIND_AVX2
+
+using Detail::KernelIsa;
+
+KernelIsa detectIsa() noexcept {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return KernelIsa::Avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return KernelIsa::Avx2;
+    return KernelIsa::Generic;
+}
+
+KernelIsa supportedIsa() noexcept {
+    static KernelIsa const isa(detectIsa());
+    return isa;
+}
+
+std::atomic<KernelIsa> maxIsa(KernelIsa::Avx512);
+
+/** \returns the instruction set to use for the given network. */
+KernelIsa kernelIsa(CompiledNetwork const & network) noexcept {
+    /* The vector gathers and scatters take signed 32-bit indexes: */
+    if (network.numInputs()
+        > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+        return KernelIsa::Generic;
+    return std::min(supportedIsa(), maxIsa.load(std::memory_order_relaxed));
+}
+
+template <typename Avx2Ops, typename Avx512Ops, typename T>
+bool dispatch(CompiledNetwork const & network, T * first) noexcept {
+    switch (kernelIsa(network)) {
+    case KernelIsa::Avx512:
+        runAvx512<Avx512Ops>(network, first);
+        return true;
+    case KernelIsa::Avx2:
+        runAvx2<Avx2Ops>(network, first);
+        return true;
+    case KernelIsa::Generic:
+        break;
+    }
+    return false;
+}
+
+bool runKernel(CompiledNetwork const & network, std::int32_t * first) noexcept {
+    return dispatch<Avx2Int32Ops<std::int32_t, 0u>,
+                    Avx512Int32Ops<std::int32_t, true> >(network, first);
+}
+
+bool runKernel(CompiledNetwork const & network, std::uint32_t * first) noexcept
+{
+    return dispatch<Avx2Int32Ops<std::uint32_t, 0x80000000u>,
+                    Avx512Int32Ops<std::uint32_t, false> >(network, first);
+}
+
+bool runKernel(CompiledNetwork const & network, std::int64_t * first) noexcept {
+    return dispatch<Avx2Int64Ops<std::int64_t, 0u>,
+                    Avx512Int64Ops<std::int64_t, true> >(network, first);
+}
+
+bool runKernel(CompiledNetwork const & network, std::uint64_t * first) noexcept
+{
+    return dispatch<Avx2Int64Ops<std::uint64_t, 0x8000000000000000u>,
+                    Avx512Int64Ops<std::uint64_t, false> >(network, first);
+}
+
+bool runKernel(CompiledNetwork const & network, float * first) noexcept
+{ return dispatch<Avx2FloatOps, Avx512FloatOps>(network, first); }
+
+bool runKernel(CompiledNetwork const & network, double * first) noexcept
+{ return dispatch<Avx2DoubleOps, Avx512DoubleOps>(network, first); }
+
+#else /* SHAREMIND_LIBSORTNETWORK_X86_KERNELS */
+
+template <typename T>
+bool runKernel(CompiledNetwork const &, T *) noexcept { return false; }
+
+#endif /* SHAREMIND_LIBSORTNETWORK_X86_KERNELS */
+
+} // anonymous namespace
+
+namespace Detail {
+
+#ifdef SHAREMIND_LIBSORTNETWORK_X86_KERNELS
+
+KernelIsa supportedKernelIsa() noexcept { return supportedIsa(); }
+
+void setMaxKernelIsa(KernelIsa isa) noexcept
+{ maxIsa.store(isa, std::memory_order_relaxed); }
+
+#else /* SHAREMIND_LIBSORTNETWORK_X86_KERNELS */
+
+KernelIsa supportedKernelIsa() noexcept { return KernelIsa::Generic; }
+
+void setMaxKernelIsa(KernelIsa) noexcept {}
+
+#endif /* SHAREMIND_LIBSORTNETWORK_X86_KERNELS */
+
+} /* namespace Detail { */
+
+void CompiledNetwork::sortValues(std::int32_t * first) const {
+    if (!runKernel(*this, first))
+        sortValues<std::int32_t *>(first);
+}
+
+void CompiledNetwork::sortValues(std::uint32_t * first) const {
+    if (!runKernel(*this, first))
+        sortValues<std::uint32_t *>(first);
+}
+
+void CompiledNetwork::sortValues(std::int64_t * first) const {
+    if (!runKernel(*this, first))
+        sortValues<std::int64_t *>(first);
+}
+
+void CompiledNetwork::sortValues(std::uint64_t * first) const {
+    if (!runKernel(*this, first))
+        sortValues<std::uint64_t *>(first);
+}
+
+void CompiledNetwork::sortValues(float * first) const {
+    if (!runKernel(*this, first))
+        sortValues<float *>(first);
+}
+
+void CompiledNetwork::sortValues(double * first) const {
+    if (!runKernel(*this, first))
+        sortValues<double *>(first);
+}
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_EXCHANGE_H
+#define SHAREMIND_LIBSORTNETWORK_EXCHANGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+
+/*
+  Exchange policies determine how the sortValues() functions exchange the
+  values on the two lines of a comparator. An exchange policy is a function
+  object callable as exchange(minValue, maxValue, doSwap), where minValue and
+  maxValue are references to the values on the minimum and maximum lines of
+  the comparator and doSwap is the result of comparing them. The policy must
+  swap the two values if and only if doSwap is true. Any user-provided
+  function object satisfying this (e.g. a data-oblivious swap of secret-shared
+  values) can be used as an exchange policy.
+*/
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace Detail {
+
+/* Whether Exchange is callable as an exchange policy on values of type T: */
+template <typename Exchange, typename T, typename = void>
+struct IsExchangePolicy: std::false_type {};
+
+template <typename Exchange, typename T>
+struct IsExchangePolicy<
+        Exchange,
+        T,
+        decltype(void(std::declval<Exchange &>()(std::declval<T &>(),
+                                                 std::declval<T &>(),
+                                                 true)))>
+    : std::true_type {};
+
+template <typename U>
+void branchFreeExchangeChunks(unsigned char * a,
+                              unsigned char * b,
+                              std::size_t & offset,
+                              std::size_t size,
+                              U const mask) noexcept
+{
+    for (; size - offset >= sizeof(U); offset += sizeof(U)) {
+        U x;
+        U y;
+        std::memcpy(&x, a + offset, sizeof(U));
+        std::memcpy(&y, b + offset, sizeof(U));
+        U const diff = static_cast<U>((x ^ y) & mask);
+        x = static_cast<U>(x ^ diff);
+        y = static_cast<U>(y ^ diff);
+        std::memcpy(a + offset, &x, sizeof(U));
+        std::memcpy(b + offset, &y, sizeof(U));
+    }
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value
+                        && !std::is_same<T, bool>::value>::type
+branchFreeExchange(T & a, T & b, bool doSwap) noexcept {
+    using U = typename std::make_unsigned<T>::type;
+    auto const mask = static_cast<U>(static_cast<U>(0u) - doSwap);
+    auto const diff = static_cast<U>((static_cast<U>(a) ^ static_cast<U>(b))
+                                     & mask);
+    a = static_cast<T>(static_cast<U>(a) ^ diff);
+    b = static_cast<T>(static_cast<U>(b) ^ diff);
+}
+
+template <typename T>
+typename std::enable_if<!std::is_integral<T>::value
+                        || std::is_same<T, bool>::value>::type
+branchFreeExchange(T & a, T & b, bool doSwap) noexcept {
+    auto * const aBytes =
+            reinterpret_cast<unsigned char *>(std::addressof(a));
+    auto * const bBytes =
+            reinterpret_cast<unsigned char *>(std::addressof(b));
+    auto const mask = static_cast<std::uint64_t>(0u) - doSwap;
+    std::size_t offset = 0u;
+    branchFreeExchangeChunks(aBytes, bBytes, offset, sizeof(T), mask);
+    branchFreeExchangeChunks(aBytes,
+                             bBytes,
+                             offset,
+                             sizeof(T),
+                             static_cast<std::uint32_t>(mask));
+    branchFreeExchangeChunks(aBytes,
+                             bBytes,
+                             offset,
+                             sizeof(T),
+                             static_cast<std::uint16_t>(mask));
+    branchFreeExchangeChunks(aBytes,
+                             bBytes,
+                             offset,
+                             sizeof(T),
+                             static_cast<unsigned char>(mask));
+}
+
+} /* namespace Detail { */
+
+/**
+  The default exchange policy, which swaps the values using std::swap() only if
+  needed. This is usually the fastest policy on nearly sorted inputs, but the
+  branch is hard to predict on random inputs and its timing depends on the
+  values being sorted.
+*/
+struct BranchingExchange {
+
+    template <typename T>
+    void operator()(T & minValue, T & maxValue, bool doSwap) const {
+        if (doSwap)
+            std::swap(minValue, maxValue);
+    }
+
+};
+
+/**
+  An exchange policy for trivially copyable types which does not branch on the
+  result of the comparison. Instead, the object representations of both values
+  are always rewritten by XOR-ing them with their difference masked by the
+  result of the comparison, which compilers typically lower to conditional
+  moves or blends. This avoids branch mispredictions on random inputs and the
+  accesses made do not depend on the values being sorted.
+  \note Whether the comparison itself runs in constant time depends on the
+        comparison function object used.
+*/
+struct BranchFreeExchange {
+
+    template <typename T>
+    void operator()(T & minValue, T & maxValue, bool doSwap) const noexcept {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "BranchFreeExchange requires trivially copyable types!");
+        Detail::branchFreeExchange(minValue, maxValue, doSwap);
+    }
+
+};
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_EXCHANGE_H */
@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_GENERATORS_H
+#define SHAREMIND_LIBSORTNETWORK_GENERATORS_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace Detail {
+
+/*
+  The functions below emit the comparators of the sorting networks and mergers
+  straight from index arithmetic in execution order, i.e. every comparator is
+  emitted after all earlier comparators on the same lines, by calling
+  builder.addComparator(min, max) for each comparator. They are used both by
+  the runtime generators of Network and by StaticNetwork at compile time.
+*/
+
+template <typename Builder>
+constexpr void emitComparator(Builder & builder,
+                              std::size_t a,
+                              std::size_t b,
+                              bool inverted)
+{
+    if (inverted) {
+        builder.addComparator(b, a);
+    } else {
+        builder.addComparator(a, b);
+    }
+}
+
+template <typename Builder>
+constexpr void emitBitonicMerger(Builder & builder,
+                                 std::size_t numIndexes,
+                                 std::size_t offset,
+                                 std::size_t skip,
+                                 bool inverted)
+{
+    if (numIndexes <= 1u)
+        return;
+    if (numIndexes > 2u) {
+        emitBitonicMerger(builder,
+                          numIndexes - numIndexes / 2u,
+                          offset,
+                          2u * skip,
+                          inverted);
+        emitBitonicMerger(builder,
+                          numIndexes / 2u,
+                          offset + skip,
+                          2u * skip,
+                          inverted);
+    }
+    for (std::size_t i = 1u; i < numIndexes; i += 2u) {
+        auto const secondIndex = offset + (skip * i);
+        emitComparator(builder, secondIndex - skip, secondIndex, inverted);
+    }
+}
+
+template <typename Builder>
+constexpr void emitBitonicMergeSort(Builder & builder,
+                                    std::size_t numInputs,
+                                    std::size_t offset,
+                                    bool inverted)
+{
+    if (numInputs <= 2u) {
+        if (numInputs == 2u)
+            emitComparator(builder, offset, offset + 1u, inverted);
+        return;
+    }
+    auto const numInputsLeft = numInputs / 2u;
+    // The left half is inverted, see combineBitonicMerge():
+    emitBitonicMergeSort(builder, numInputsLeft, offset, !inverted);
+    emitBitonicMergeSort(builder,
+                         numInputs - numInputsLeft,
+                         offset + numInputsLeft,
+                         inverted);
+    emitBitonicMerger(builder, numInputs, offset, 1u, inverted);
+}
+
+template <typename Builder>
+constexpr void emitOddEvenMerger(Builder & builder,
+                                 std::size_t numLeftIndexes,
+                                 std::size_t leftOffset,
+                                 std::size_t leftSkip,
+                                 std::size_t numRightIndexes,
+                                 std::size_t rightOffset,
+                                 std::size_t rightSkip)
+{
+    if (!numLeftIndexes || !numRightIndexes)
+        return;
+    if ((numLeftIndexes == 1u) && (numRightIndexes == 1u)) {
+        builder.addComparator(leftOffset, rightOffset);
+        return;
+    }
+
+    /* Merge odd sequences */
+    emitOddEvenMerger(builder,
+                      numLeftIndexes - numLeftIndexes / 2u,
+                      leftOffset,
+                      leftSkip * 2u,
+                      numRightIndexes - numRightIndexes / 2u,
+                      rightOffset,
+                      rightSkip * 2u);
+
+    /* Merge even sequences */
+    emitOddEvenMerger(builder,
+                      numLeftIndexes / 2u,
+                      leftOffset + leftSkip,
+                      leftSkip * 2u,
+                      numRightIndexes / 2u,
+                      rightOffset + rightSkip,
+                      rightSkip * 2u);
+
+    /* Apply ``comparison-interchange'' operations. */
+    auto maxIndex = numLeftIndexes + numRightIndexes;
+    maxIndex -= (maxIndex % 2u) ? 2u : 3u;
+    for (std::size_t i = 1u; i <= maxIndex; i += 2u)
+        builder.addComparator(
+                    (i < numLeftIndexes)
+                    ? (leftOffset + i * leftSkip)
+                    : (rightOffset + (i - numLeftIndexes) * rightSkip),
+                    ((i + 1u) < numLeftIndexes)
+                    ? (leftOffset + (i + 1u) * leftSkip)
+                    : (rightOffset + (i - numLeftIndexes + 1u) * rightSkip));
+}
+
+/**
+  Applies the emitted comparators to the range of values starting at first as
+  they are emitted, using the given comparison function object and exchange
+  policy.
+*/
+template <typename It, typename Comp, typename Exchange>
+struct ValueApplier {
+    void addComparator(std::size_t min, std::size_t max) {
+        using D = typename std::iterator_traits<It>::difference_type;
+        auto & minValue = first[static_cast<D>(min)];
+        auto & maxValue = first[static_cast<D>(max)];
+        exchange(minValue, maxValue, comp(maxValue, minValue));
+    }
+
+    It first;
+    Comp comp;
+    Exchange exchange;
+};
+
+/**
+  Forwards the comparators between lines in the range [begin, end) to another
+  builder with their lines moved to start from offset, dropping all others.
+*/
+template <typename Builder>
+struct LineRangeBuilder {
+    constexpr void addComparator(std::size_t min, std::size_t max) {
+        if ((min >= begin) && (min < end) && (max >= begin) && (max < end))
+            builder.addComparator(min - begin + offset, max - begin + offset);
+    }
+
+    Builder & builder;
+    std::size_t begin;
+    std::size_t end;
+    std::size_t offset;
+};
+
+/**
+  Emits a bitonic merger of a sorted sequence of numLeftIndexes values followed
+  by a sorted sequence of numRightIndexes values, i.e. the merger comparing the
+  lines i and 2h - 1 - i of the two halves of size h (a power of two) followed
+  by the half-cleaners of both halves. Unless both sequences have h values,
+  the left one is padded below with -inf values and the right one above with
+  +inf values. These stay on their lines, hence their lines and all comparators
+  on them are dropped.
+*/
+template <typename Builder>
+constexpr void emitBitonicRunMerger(Builder & builder,
+                                    std::size_t numLeftIndexes,
+                                    std::size_t numRightIndexes,
+                                    std::size_t offset)
+{
+    std::size_t half = 1u;
+    while ((half < numLeftIndexes) || (half < numRightIndexes))
+        half *= 2u;
+    LineRangeBuilder<Builder> range{builder,
+                                    half - numLeftIndexes,
+                                    half + numRightIndexes,
+                                    offset};
+    for (std::size_t i = 0u; i < half; ++i)
+        range.addComparator(i, 2u * half - 1u - i);
+    for (std::size_t skip = half / 2u; skip; skip /= 2u)
+        for (std::size_t block = 0u; block < 2u * half; block += 2u * skip)
+            for (std::size_t i = block; i < block + skip; ++i)
+                range.addComparator(i, i + skip);
+}
+
+template <typename Builder>
+constexpr void emitOddEvenMergeSort(Builder & builder,
+                                    std::size_t numInputs,
+                                    std::size_t offset)
+{
+    if (numInputs <= 2u) {
+        if (numInputs == 2u)
+            builder.addComparator(offset, offset + 1u);
+        return;
+    }
+    auto const numInputsLeft = numInputs / 2u;
+    auto const numInputsRight = numInputs - numInputsLeft;
+    emitOddEvenMergeSort(builder, numInputsLeft, offset);
+    emitOddEvenMergeSort(builder, numInputsRight, offset + numInputsLeft);
+    emitOddEvenMerger(builder,
+                      numInputsLeft,
+                      offset,
+                      1u,
+                      numInputsRight,
+                      offset + numInputsLeft,
+                      1u);
+}
+
+template <typename Builder>
+constexpr void emitPairwiseSort(Builder & builder,
+                                std::size_t numIndexes,
+                                std::size_t offset,
+                                std::size_t skip)
+{
+    for (std::size_t i = 1u; i < numIndexes; i += 2u)
+        builder.addComparator(offset + (i - 1u) * skip, offset + i * skip);
+    if (numIndexes <= 2u)
+        return;
+
+    /* Sort "pairs" recursively. Like with odd-even mergesort, odd and even
+       lines are handled recursively and later reunited. */
+    emitPairwiseSort(builder,
+                     numIndexes - numIndexes / 2u,
+                     offset,
+                     skip * 2u);
+    emitPairwiseSort(builder, numIndexes / 2u, offset + skip, skip * 2u);
+
+    /* m is the "amplitude" of the sorted pairs. This is a bit tricky to read
+       due to different indices being used in the paper, unfortunately. */
+    auto m = (numIndexes + 1u) / 2u;
+    while (m > 1u) {
+        auto const len = (m % 2u) ? m : (m - 1u);
+        for (std::size_t i = 1u; i + len < numIndexes; i += 2u)
+            builder.addComparator(offset + (i * skip),
+                                  offset + ((i + len) * skip));
+        m = (m + 1u) / 2u;
+    }
+}
+
+/**
+  Sorts the comparators of a stage by their left lines. Unless the stage is
+  sparse, i.e. has fewer than numLines / 16 comparators, this is a bucket sort
+  using a 1-based slot per line.
+  \param[in,out] comparators The comparators of the stage.
+  \param[out] buffer A buffer for the sorted comparators.
+  \param[in] numLines The number of lines of the network.
+  \param[in] slotOf A function object returning a reference to the slot of the
+                    line given as its argument. All slots must be zero on entry
+                    and are zero on return.
+*/
+template <typename Comparators, typename SlotOf>
+void sortByLeft(Comparators & comparators,
+                Comparators & buffer,
+                std::size_t numLines,
+                SlotOf && slotOf)
+{
+    auto const numComparators = comparators.size();
+    if (numComparators * 16u < numLines) {
+        std::sort(comparators.begin(), comparators.end());
+        return;
+    }
+    for (std::size_t i = 0u; i < numComparators; ++i) {
+        auto & slot = slotOf(comparators[i].left());
+        assert(!slot);
+        slot = i + 1u;
+    }
+    buffer.clear();
+    buffer.reserve(numComparators);
+    for (std::size_t line = 0u; line < numLines; ++line) {
+        auto & slot = slotOf(line);
+        if (slot) {
+            buffer.emplace_back(comparators[slot - 1u]);
+            slot = 0u;
+        }
+    }
+    std::copy(buffer.begin(), buffer.end(), comparators.begin());
+}
+
+} /* namespace Detail { */
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_GENERATORS_H */
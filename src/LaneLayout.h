@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_LANELAYOUT_H
+#define SHAREMIND_LIBSORTNETWORK_LANELAYOUT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <sharemind/Concepts.h>
+#include <sharemind/Iterator.h>
+
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace Detail {
+
+/** The side length of the tiles used when transposing: */
+constexpr std::size_t const laneTransposeTileSize = 16u;
+
+template <typename InIt, typename OutIt>
+void transposeTiled(InIt in,
+                    std::size_t const numRows,
+                    std::size_t const numColumns,
+                    OutIt out)
+{
+    using InD = typename std::iterator_traits<InIt>::difference_type;
+    using OutD = typename std::iterator_traits<OutIt>::difference_type;
+    constexpr auto const tile = laneTransposeTileSize;
+    for (std::size_t r0 = 0u; r0 < numRows; r0 += tile) {
+        auto const r1 = std::min(numRows, r0 + tile);
+        for (std::size_t c0 = 0u; c0 < numColumns; c0 += tile) {
+            auto const c1 = std::min(numColumns, c0 + tile);
+            for (std::size_t r = r0; r < r1; ++r)
+                for (std::size_t c = c0; c < c1; ++c)
+                    out[static_cast<OutD>(c * numRows + r)] =
+                            in[static_cast<InD>(r * numColumns + c)];
+        }
+    }
+}
+
+} /* namespace Detail { */
+
+/**
+  Converts a batch of equal-length arrays from the usual layout, where the
+  arrays are stored one after another (i.e. the j-th value of the i-th array is
+  stored at first[i * arraySize + j]) into the transposed (lane) layout used by
+  the sortValuesBatch() functions, where the j-th value of the i-th array is
+  stored at out[j * numArrays + i].
+  \param[in] first Iterator to the first value of the first array.
+  \param[in] numArrays The number of arrays in the batch.
+  \param[in] arraySize The number of values in each array.
+  \param[in] out Iterator to the output range.
+  \pre The input and output ranges must not overlap.
+*/
+template <typename InIt,
+          typename OutIt,
+          SHAREMIND_REQUIRES_CONCEPTS(RandomAccessIterator(InIt),
+                                      RandomAccessIterator(OutIt))>
+void toLaneLayout(InIt first,
+                  std::size_t numArrays,
+                  std::size_t arraySize,
+                  OutIt out)
+{ Detail::transposeTiled(first, numArrays, arraySize, out); }
+
+/**
+  Converts a batch of equal-length arrays from the transposed (lane) layout
+  used by the sortValuesBatch() functions, where the j-th value of the i-th
+  array is stored at first[j * numArrays + i], back to the usual layout where
+  the arrays are stored one after another (i.e. the j-th value of the i-th
+  array is stored at out[i * arraySize + j]).
+  \param[in] first Iterator to the first value of the batch.
+  \param[in] numArrays The number of arrays in the batch.
+  \param[in] arraySize The number of values in each array.
+  \param[in] out Iterator to the output range.
+  \pre The input and output ranges must not overlap.
+*/
+template <typename InIt,
+          typename OutIt,
+          SHAREMIND_REQUIRES_CONCEPTS(RandomAccessIterator(InIt),
+                                      RandomAccessIterator(OutIt))>
+void fromLaneLayout(InIt first,
+                    std::size_t numArrays,
+                    std::size_t arraySize,
+                    OutIt out)
+{ Detail::transposeTiled(first, arraySize, numArrays, out); }
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_LANELAYOUT_H */
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_MERGE_H
+#define SHAREMIND_LIBSORTNETWORK_MERGE_H
+
+#include <cstddef>
+#include <iterator>
+#include <sharemind/Concepts.h>
+#include <sharemind/Iterator.h>
+#include <type_traits>
+#include "Exchange.h"
+#include "Generators.h"
+
+
+namespace sharemind {
+namespace SortingNetwork {
+
+/**
+  Merges a sorted sequence of n0 values followed by a sorted sequence of n1
+  values by applying the comparators of the Odd-Even-Merger (see
+  Network::makeOddEvenMerger()) as they are generated, i.e. without building
+  a network. Unlike a full sorting network, this takes only O(log(n0 + n1))
+  stages.
+
+  \pre The values in [first, first + n0) and [first + n0, first + n0 + n1)
+       must be sorted.
+  \param[in] first Iterator to the first value of the first sequence.
+  \param[in] n0 The number of values in the first sequence.
+  \param[in] n1 The number of values in the second sequence.
+*/
+template <typename It,
+          SHAREMIND_REQUIRES_CONCEPTS(
+                RandomAccessIterator(It),
+                LessThanComparable(
+                        typename std::iterator_traits<It>::value_type),
+                Swappable(typename std::iterator_traits<It>::value_type))>
+void mergeValues(It first, std::size_t n0, std::size_t n1) {
+    using T = typename std::iterator_traits<It>::value_type;
+    auto less = [](T const & a, T const & b) { return a < b; };
+    Detail::ValueApplier<It, decltype(less) &, BranchingExchange> merger{
+            first,
+            less,
+            BranchingExchange()};
+    Detail::emitOddEvenMerger(merger, n0, 0u, 1u, n1, n0, 1u);
+}
+
+/**
+  Merges a sorted sequence of n0 values followed by a sorted sequence of n1
+  values by applying the comparators of the Odd-Even-Merger as they are
+  generated.
+
+  \pre The values in [first, first + n0) and [first + n0, first + n0 + n1)
+       must be sorted with respect to comp.
+  \param[in] first Iterator to the first value of the first sequence.
+  \param[in] n0 The number of values in the first sequence.
+  \param[in] n1 The number of values in the second sequence.
+  \param[in] comp The comparison function object which returns true if its
+                  first argument is less than (i.e. is ordered before) its
+                  second argument. The comparison function object must be
+                  callable as comp(first[i], first[j]) for any valid i and j
+                  and must not modify the objects passed to it.
+*/
+template <typename It,
+          typename Comp,
+          SHAREMIND_REQUIRES_CONCEPTS(
+                RandomAccessIterator(It),
+                Swappable(typename std::iterator_traits<It>::value_type),
+                BinaryPredicate(
+                        Comp,
+                        typename std::iterator_traits<It>::value_type,
+                        typename std::iterator_traits<It>::value_type))>
+void mergeValues(It first, std::size_t n0, std::size_t n1, Comp comp) {
+    Detail::ValueApplier<It, Comp &, BranchingExchange> merger{
+            first,
+            comp,
+            BranchingExchange()};
+    Detail::emitOddEvenMerger(merger, n0, 0u, 1u, n1, n0, 1u);
+}
+
+/**
+  Merges a sorted sequence of n0 values followed by a sorted sequence of n1
+  values by applying the comparators of the Odd-Even-Merger as they are
+  generated, using the given exchange policy and operator<() for comparisons.
+
+  \pre The values in [first, first + n0) and [first + n0, first + n0 + n1)
+       must be sorted.
+  \param[in] first Iterator to the first value of the first sequence.
+  \param[in] n0 The number of values in the first sequence.
+  \param[in] n1 The number of values in the second sequence.
+  \param[in] exchange The exchange policy (see Exchange.h), callable as
+                      exchange(first[i], first[j], doSwap) for any valid i and
+                      j, which must swap its first two arguments if and only if
+                      doSwap is true.
+*/
+template <typename It,
+          typename Exchange,
+          SHAREMIND_REQUIRES_CONCEPTS(
+                RandomAccessIterator(It),
+                LessThanComparable(
+                        typename std::iterator_traits<It>::value_type)),
+          typename std::enable_if<
+                Detail::IsExchangePolicy<
+                        Exchange,
+                        typename std::iterator_traits<It>::value_type
+                >::value,
+                int>::type = 0>
+void mergeValues(It first, std::size_t n0, std::size_t n1, Exchange exchange) {
+    using T = typename std::iterator_traits<It>::value_type;
+    auto less = [](T const & a, T const & b) { return a < b; };
+    Detail::ValueApplier<It, decltype(less) &, Exchange &> merger{first,
+                                                                  less,
+                                                                  exchange};
+    Detail::emitOddEvenMerger(merger, n0, 0u, 1u, n1, n0, 1u);
+}
+
+/**
+  Merges a sorted sequence of n0 values followed by a sorted sequence of n1
+  values by applying the comparators of the Odd-Even-Merger as they are
+  generated, using the given exchange policy.
+
+  \pre The values in [first, first + n0) and [first + n0, first + n0 + n1)
+       must be sorted with respect to comp.
+  \param[in] first Iterator to the first value of the first sequence.
+  \param[in] n0 The number of values in the first sequence.
+  \param[in] n1 The number of values in the second sequence.
+  \param[in] comp The comparison function object which returns true if its
+                  first argument is less than (i.e. is ordered before) its
+                  second argument. The comparison function object must be
+                  callable as comp(first[i], first[j]) for any valid i and j
+                  and must not modify the objects passed to it.
+  \param[in] exchange The exchange policy (see Exchange.h), callable as
+                      exchange(first[i], first[j], doSwap) for any valid i and
+                      j, which must swap its first two arguments if and only if
+                      doSwap is true.
+*/
+template <typename It,
+          typename Comp,
+          typename Exchange,
+          SHAREMIND_REQUIRES_CONCEPTS(
+                RandomAccessIterator(It),
+                BinaryPredicate(
+                        Comp,
+                        typename std::iterator_traits<It>::value_type,
+                        typename std::iterator_traits<It>::value_type))>
+void mergeValues(It first,
+                 std::size_t n0,
+                 std::size_t n1,
+                 Comp comp,
+                 Exchange exchange)
+{
+    Detail::ValueApplier<It, Comp &, Exchange &> merger{first, comp, exchange};
+    Detail::emitOddEvenMerger(merger, n0, 0u, 1u, n1, n0, 1u);
+}
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_MERGE_H */
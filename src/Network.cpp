@@ -25,318 +25,489 @@
 
 #include <algorithm>
 #include <limits>
-#include <list>
 #include <stdexcept>
 #include <type_traits>
 #include <utility>
+#include <vector>
+#include "Generators.h"
 
 
 namespace sharemind {
 namespace SortingNetwork {
 namespace {
 
-struct StrideJob {
-    std::size_t const m_numIndexes;
-    std::size_t const m_offset;
-    std::size_t const m_skip;
-    bool const m_isRecursive;
-};
+/**
+  Places the comparators added in execution order into the earliest stage
+  following all stages of earlier comparators on the same lines, and drops a
+  comparator if that stage already contains an identical comparator. All
+  comparators are added twice: first only to count the comparators of each
+  stage, and after allocateStages() to fill the stages, such that every stage
+  is allocated only once.
+*/
+class StageScheduler {
+
+public: /* Methods: */
+
+    explicit StageScheduler(std::size_t numLines)
+        : m_lines(numLines, LineState{0u, 0u, 0u})
+    {}
+
+    void addComparator(std::size_t min, std::size_t max) {
+        assert(min < m_lines.size());
+        assert(max < m_lines.size());
+        auto & minLine = m_lines[min];
+        auto & maxLine = m_lines[max];
+        auto const stage = std::max(minLine.stage, maxLine.stage);
+        if ((stage != 0u)
+            && (minLine.stage == stage)
+            && (minLine.min == min)
+            && (minLine.max == max))
+            return;
+        minLine = maxLine = LineState{stage + 1u, min, max};
+        if (m_counting) {
+            if (stage == m_stageSizes.size())
+                m_stageSizes.emplace_back(0u);
+            ++m_stageSizes[stage];
+        } else {
+            assert(stage < m_comparators.size());
+            m_comparators[stage].emplace_back(min, max);
+        }
+    }
 
-std::list<StrideJob> bitonicMergerRecursive(std::size_t const numIndexes,
-                                            std::size_t const offset,
-                                            std::size_t const skip)
-{
-    std::list<StrideJob> jobs;
-    assert(numIndexes > 0u);
-    if (numIndexes <= 1u)
-        return jobs;
-
-    if (numIndexes > 2u) {
-        auto const odd_indizes_num = numIndexes / 2u;
-        auto const even_indizes_num = numIndexes - odd_indizes_num;
-
-        jobs.emplace_back(
-                    StrideJob{even_indizes_num, offset, 2u * skip, true});
-        jobs.emplace_back(
-                    StrideJob{odd_indizes_num, offset + skip, 2u * skip, true});
+    void allocateStages() {
+        assert(m_counting);
+        m_comparators.resize(m_stageSizes.size());
+        for (std::size_t i = 0u; i < m_stageSizes.size(); ++i)
+            m_comparators[i].reserve(m_stageSizes[i]);
+        resetLines();
+        m_counting = false;
     }
-    jobs.emplace_back(StrideJob{numIndexes, offset, skip, false});
-    return jobs;
+
+    Network::Stages releaseStages() {
+        assert(!m_counting);
+        resetLines();
+        Network::Stages r;
+        r.reserve(m_comparators.size());
+        Stage::Comparators buffer;
+        for (auto & comparators : m_comparators) {
+            assert(comparators.size() == comparators.capacity());
+            sortByLeft(comparators, buffer);
+            r.emplace_back(std::move(comparators));
+        }
+        return r;
+    }
+
+private: /* Methods: */
+
+    void resetLines() noexcept {
+        for (auto & line : m_lines)
+            line.stage = 0u;
+    }
+
+    /**
+      Sorts the comparators of a stage by their left lines, using the zeroed
+      stage fields of m_lines as the slots of Detail::sortByLeft().
+    */
+    void sortByLeft(Stage::Comparators & comparators,
+                    Stage::Comparators & buffer)
+    {
+        Detail::sortByLeft(comparators,
+                           buffer,
+                           m_lines.size(),
+                           [this](std::size_t line) -> std::size_t &
+                           { return m_lines[line].stage; });
+    }
+
+private: /* Fields: */
+
+    /* Per line, the 1-based index of and the comparator in its last stage: */
+    struct LineState {
+        std::size_t stage;
+        std::size_t min;
+        std::size_t max;
+    };
+    std::vector<LineState> m_lines;
+
+    bool m_counting = true;
+    std::vector<std::size_t> m_stageSizes;
+    std::vector<Stage::Comparators> m_comparators;
+
+};
+
+/**
+  \returns the stages scheduled by a StageScheduler from the comparators
+           emitted by emit(scheduler).
+*/
+template <typename Emit>
+Network::Stages scheduleStages(std::size_t numLines, Emit const & emit) {
+    StageScheduler scheduler(numLines);
+    emit(scheduler);
+    scheduler.allocateStages();
+    emit(scheduler);
+    return scheduler.releaseStages();
+}
+
+template <typename Emit>
+Network makeScheduledNetwork(std::size_t numInputs, Emit const & emit) {
+    Network n(numInputs);
+    n.composeWithStages(scheduleStages(numInputs, emit));
+    return n;
 }
 
-void addBitonicMerger(Network & n, std::size_t const numIndexes) {
-    auto jobs(bitonicMergerRecursive(numIndexes, 0u, 1u));
-    while (!jobs.empty()) {
-        StrideJob const job(std::move(jobs.front()));
-        jobs.pop_front();
+/*
+  For numbers of inputs n = 2^k the stages which a StageScheduler computes for
+  the sorting networks are known in closed form, hence these are written
+  straight into stages allocated to their exact sizes. All three networks then
+  have k(k+1)/2 stages, and the functions below call f(min, max) for every
+  comparator of the given stage in ascending order of the left lines.
+*/
 
-        if (job.m_isRecursive) {
-            jobs.splice(jobs.begin(),
-                        bitonicMergerRecursive(job.m_numIndexes,
-                                               job.m_offset,
-                                               job.m_skip));
-        } else {
-            assert(job.m_numIndexes > 1u);
-            for (std::size_t i = 1u; i < job.m_numIndexes; i += 2u) {
-                auto const secondIndex = job.m_offset + (job.m_skip * i);
-                n.composeWith(Comparator(secondIndex - job.m_skip,
-                                         secondIndex));
+bool isPowerOfTwo(std::size_t n) noexcept { return n && !(n & (n - 1u)); }
+
+std::size_t log2OfPowerOfTwo(std::size_t n) noexcept {
+    assert(isPowerOfTwo(n));
+    std::size_t r = 0u;
+    for (; n > 1u; n /= 2u)
+        ++r;
+    return r;
+}
+
+/**
+  Splits the index of a stage of a network consisting of phases q = 0, 1, ...
+  of q + 1 stages each into the phase and the index of the stage in the phase.
+*/
+std::pair<std::size_t, std::size_t> phaseOfStage(std::size_t stage) noexcept {
+    std::size_t phase = 0u;
+    for (; stage > phase; stage -= ++phase) {}
+    return std::make_pair(phase, stage);
+}
+
+/**
+  In phase q of Batcher's odd-even merge sort the sorted blocks of size p = 2^q
+  are merged pairwise by comparing the lines p, p/2, ..., 1 apart. The first
+  and the last lines of each block are only compared in the first stage of every
+  phase, hence the scheduler moves the comparators on these lines from the first
+  stage of phase q to stage q, which is the only difference to the recursion.
+*/
+template <typename F>
+void forEachOddEvenMergeSortComparator(std::size_t numInputs,
+                                       std::size_t stage,
+                                       F && f)
+{
+    auto const phaseAndStep(phaseOfStage(stage));
+    auto const blockSize = std::size_t(1u) << phaseAndStep.first;
+    auto const distance = blockSize >> phaseAndStep.second;
+    bool const skipMoved = (phaseAndStep.first >= 2u)
+                           && (phaseAndStep.second == 0u);
+
+    // The comparators of phase "stage" moved here, merged in by left lines:
+    bool const hasMoved = (stage >= 2u)
+                          && (stage < log2OfPowerOfTwo(numInputs));
+    auto const movedBlockSize = hasMoved ? (std::size_t(1u) << stage) : 0u;
+    auto moved = hasMoved ? std::size_t(0u) : numInputs;
+    auto const emitMovedBefore =
+            [&f, &moved, movedBlockSize](std::size_t line) {
+                for (; moved < line; moved += (moved % (2u * movedBlockSize))
+                                              ? movedBlockSize + 1u
+                                              : movedBlockSize - 1u)
+                    f(moved, moved + movedBlockSize);
+            };
+
+    for (auto j = distance % blockSize;
+         j + distance < numInputs;
+         j += 2u * distance)
+    {
+        for (auto min = j; min < j + distance; ++min) {
+            auto const max = min + distance;
+            auto const i = min % (2u * blockSize);
+            if ((i + distance >= 2u * blockSize)
+                || (skipMoved && ((i == 0u) || (i == blockSize - 1u))))
+                continue;
+            emitMovedBefore(min);
+            f(min, max);
+        }
+    }
+    emitMovedBefore(numInputs);
+}
+
+/**
+  In phase q of the bitonic merge sort the blocks of size 2^(q+1) are merged by
+  comparing the lines 2^q, 2^(q-1), ..., 1 apart, where a block is merged in
+  reverse order iff it lies in the left halves of an odd number of the blocks
+  containing it, see Detail::emitBitonicMergeSort().
+*/
+template <typename F>
+void forEachBitonicMergeSortComparator(std::size_t numInputs,
+                                       std::size_t stage,
+                                       F && f)
+{
+    auto const phaseAndStep(phaseOfStage(stage));
+    auto const blockSize = std::size_t(2u) << phaseAndStep.first;
+    auto const distance = (blockSize / 2u) >> phaseAndStep.second;
+    for (std::size_t block = 0u; block < numInputs; block += blockSize) {
+        bool inverted = false;
+        for (auto bit = blockSize; bit < numInputs; bit *= 2u)
+            if (!(block & bit))
+                inverted = !inverted;
+        for (auto i = block; i < block + blockSize; ++i) {
+            if (i & distance)
+                continue;
+            if (inverted) {
+                f(i + distance, i);
+            } else {
+                f(i, i + distance);
             }
         }
     }
 }
 
+/**
+  The pairwise sorting network first compares the lines 1, 2, ..., n/2 apart in
+  stages 0 to k - 1. Then, for the subnetworks on the lines o + i * 2^l for all
+  o < 2^l, from l = k - 2 down to 0, each of size N = 2^(k - l), the layers
+  with m = N/2, N/4, ..., 2 compare their odd lines i to the lines i + m - 1.
+*/
+template <typename F>
+void forEachPairwiseSortComparator(std::size_t numInputs,
+                                   std::size_t stage,
+                                   F && f)
+{
+    auto const log2NumInputs = log2OfPowerOfTwo(numInputs);
+    if (stage < log2NumInputs) {
+        auto const distance = std::size_t(1u) << stage;
+        for (std::size_t i = 0u; i < numInputs; ++i)
+            if (!(i & distance))
+                f(i, i + distance);
+        return;
+    }
+    stage -= log2NumInputs;
+    auto skipLog2 = log2NumInputs - 2u;
+    for (;; --skipLog2) {
+        auto const numLayers = log2NumInputs - skipLog2 - 1u;
+        if (stage < numLayers)
+            break;
+        stage -= numLayers;
+    }
+    auto const skip = std::size_t(1u) << skipLog2;
+    auto const numIndexes = numInputs >> skipLog2;
+    auto const len = (numIndexes >> (stage + 1u)) - 1u;
+    for (std::size_t i = 1u; i + len < numIndexes; i += 2u)
+        for (std::size_t o = 0u; o < skip; ++o)
+            f(o + i * skip, o + (i + len) * skip);
+}
+
+/**
+  \returns the k(k+1)/2 stages of a sorting network on n = 2^k inputs, with the
+           comparators of each stage given by forEach(n, stage, f).
+*/
+template <typename ForEach>
+Network::Stages makePowerOfTwoStages(std::size_t numInputs,
+                                     ForEach const & forEach)
+{
+    auto const log2NumInputs = log2OfPowerOfTwo(numInputs);
+    auto const numStages = log2NumInputs * (log2NumInputs + 1u) / 2u;
+    Network::Stages r;
+    r.reserve(numStages);
+    for (std::size_t stage = 0u; stage < numStages; ++stage) {
+        std::size_t numComparators = 0u;
+        forEach(numInputs,
+                stage,
+                [&numComparators](std::size_t, std::size_t) noexcept
+                { ++numComparators; });
+        Stage::Comparators comparators;
+        comparators.reserve(numComparators);
+        forEach(numInputs,
+                stage,
+                [&comparators](std::size_t min, std::size_t max)
+                { comparators.emplace_back(min, max); });
+        assert(std::is_sorted(comparators.begin(), comparators.end()));
+        r.emplace_back(std::move(comparators));
+    }
+    return r;
+}
+
+template <typename ForEach>
+Network makePowerOfTwoNetwork(std::size_t numInputs, ForEach const & forEach) {
+    Network n(numInputs);
+    n.composeWithStages(makePowerOfTwoStages(numInputs, forEach));
+    return n;
+}
+
+void addComparators(StageScheduler & scheduler,
+                    Network::Stages const & stages,
+                    std::size_t offset)
+{
+    for (auto const & stage : stages)
+        for (auto const & comparator : stage.comparators())
+            scheduler.addComparator(comparator.min() + offset,
+                                    comparator.max() + offset);
+}
+
+/** Appends the emitted comparators to a network with composeWith(): */
+struct NetworkAppender {
+    void addComparator(std::size_t min, std::size_t max)
+    { network.composeWith(Comparator(min, max)); }
+
+    Network & network;
+};
+
 Network combineBitonicMerge_(Network const & n0, Network const & n1) {
     assert(std::numeric_limits<decltype(n0.numInputs())>::max() - n0.numInputs()
            >= n1.numInputs());
 
     /* We need to invert n0, because the sequence must be
          z_1 >= z_2 >= ... >= z_k <= z_{k+1} <= ... <= z_p
-       and NOT the other way around! Otherwise the comparators added in
-       addBitonicMerger() from comparing (z_0,z_1), (z_2,z_3), ... to comparing
+       and NOT the other way around! Otherwise the comparators added by
+       emitBitonicMerger() from comparing (z_0,z_1), (z_2,z_3), ... to comparing
        ...,  (z_{n-4},z_{n-3}), (z_{n-2},z_{n-1}), i.e. bound to the end of the
        list, possibly leaving z_0 uncompared. */
     auto n(n0.inverted().joinedWith(n1));
-    addBitonicMerger(n, n0.numInputs() + n1.numInputs());
+    NetworkAppender appender{n};
+    Detail::emitBitonicMerger(appender, n.numInputs(), 0u, 1u, false);
     return n;
 }
 
-struct OddEvenMergerJob {
-    std::size_t const m_numLeftIndexes;
-    std::size_t const m_leftOffset;
-    std::size_t const m_leftSkip;
-    std::size_t const m_numRightIndexes;
-    std::size_t const m_rightOffset;
-    std::size_t const m_rightSkip;
-    bool const m_isRecursive;
-};
-
-std::list<OddEvenMergerJob> oddEvenMergerRecursive(
-        std::size_t const numLeftIndexes,
-        std::size_t const leftOffset,
-        std::size_t const leftSkip,
-        std::size_t const numRightIndexes,
-        std::size_t const rightOffset,
-        std::size_t const rightSkip,
-        Network & n)
-{
-    assert(std::numeric_limits<std::size_t>::max() - numLeftIndexes
-           >= numRightIndexes);
-
-    std::list<OddEvenMergerJob> jobs;
-    if (!numLeftIndexes || !numRightIndexes)
-        return jobs;
-
-    if ((numLeftIndexes == 1u) && (numRightIndexes == 1u)) {
-        Comparator c(leftOffset, rightOffset);
-        auto & stage = n.composeWithEmptyStage();
-        stage.addComparator(std::move(c));
-        return jobs;
-    }
-
-    {
-        /* Merge odd sequences */
-        jobs.emplace_back(
-                    OddEvenMergerJob{
-                        numLeftIndexes - numLeftIndexes / 2u,
-                        leftOffset,
-                        leftSkip * 2u,
-                        numRightIndexes - numRightIndexes / 2u,
-                        rightOffset,
-                        rightSkip * 2u,
-                        true});
-
-        /* Merge even sequences */
-        jobs.emplace_back(
-                    OddEvenMergerJob{
-                        numLeftIndexes / 2u,
-                        leftOffset + leftSkip,
-                        leftSkip * 2u,
-                        numRightIndexes / 2u,
-                        rightOffset + rightSkip,
-                        rightSkip * 2u,
-                        true});
-    }
-
-    jobs.emplace_back(
-                OddEvenMergerJob{numLeftIndexes,
-                                 leftOffset,
-                                 leftSkip,
-                                 numRightIndexes,
-                                 rightOffset,
-                                 rightSkip,
-                                 false});
-    return jobs;
-}
-
-void oddEvenMergerNonRecursive(
-        std::size_t const numLeftIndexes,
-        std::size_t const leftOffset,
-        std::size_t const leftSkip,
-        std::size_t const numRightIndexes,
-        std::size_t const rightOffset,
-        std::size_t const rightSkip,
-        Network & n)
-{
-    /* Apply ``comparison-interchange'' operations. */
-    std::size_t maxIndex = numLeftIndexes + numRightIndexes;
-    assert(maxIndex > 2u);
-    if (maxIndex % 2u) {
-        maxIndex -= 2u;
-    } else {
-        maxIndex -= 3u;
-    }
-
-    Stage s;
-    for (std::size_t i = 1u; i <= maxIndex; i += 2u)
-        s.addComparator(
-                    Comparator(
-                        (i < numLeftIndexes)
-                        ? (leftOffset + i * leftSkip)
-                        : (rightOffset + (i - numLeftIndexes) * rightSkip),
-                        ((i + 1u) < numLeftIndexes)
-                        ? (leftOffset + (i + 1u) * leftSkip)
-                        : (rightOffset + (i - numLeftIndexes + 1u) * rightSkip)));
-    if (!s.empty())
-        n.composeWith(std::move(s));
-}
-
 Network combineOddEvenMerge_(Network const & n0, Network const & n1) {
     assert(std::numeric_limits<decltype(n0.numInputs())>::max() - n0.numInputs()
            >= n1.numInputs());
-    auto n(n0.joinedWith(n1));
-
-    auto jobs(oddEvenMergerRecursive(n0.numInputs(),
-                                        0u,
-                                        1u,
-                                        n1.numInputs(),
-                                        n0.numInputs(),
-                                        1u,
-                                        n));
-    while (!jobs.empty()) {
-        auto const job(std::move(jobs.front()));
-        jobs.pop_front();
-        if (job.m_isRecursive) {
-            jobs.splice(jobs.begin(),
-                        oddEvenMergerRecursive(job.m_numLeftIndexes,
-                                                  job.m_leftOffset,
-                                                  job.m_leftSkip,
-                                                  job.m_numRightIndexes,
-                                                  job.m_rightOffset,
-                                                  job.m_rightSkip,
-                                                  n));
-        } else {
-            oddEvenMergerNonRecursive(job.m_numLeftIndexes,
-                                         job.m_leftOffset,
-                                         job.m_leftSkip,
-                                         job.m_numRightIndexes,
-                                         job.m_rightOffset,
-                                         job.m_rightSkip,
-                                         n);
-        }
+    auto const numLeftInputs = n0.numInputs();
+    auto const numRightInputs = n1.numInputs();
+    return makeScheduledNetwork(
+                numLeftInputs + numRightInputs,
+                [&](StageScheduler & scheduler) {
+                    addComparators(scheduler, n0.stages(), 0u);
+                    addComparators(scheduler, n1.stages(), numLeftInputs);
+                    Detail::emitOddEvenMerger(scheduler,
+                                              numLeftInputs,
+                                              0u,
+                                              1u,
+                                              numRightInputs,
+                                              numLeftInputs,
+                                              1u);
+                });
+}
+
+/**
+  Emits a sorting network which splits its inputs into halves recursively until
+  at most leafSize inputs remain, sorts these with the given leaf networks and
+  merges the halves with Batcher's Odd-Even-Merger.
+*/
+void emitDivideAndConquerSort(StageScheduler & scheduler,
+                              std::size_t numInputs,
+                              std::size_t offset,
+                              std::vector<Network> const & leaves)
+{
+    if (numInputs < leaves.size()) {
+        addComparators(scheduler, leaves[numInputs].stages(), offset);
+        return;
     }
-    n.compress();
-    return n;
-}
-
-std::list<StrideJob> pairwiseRecursive(Network & n,
-                                       std::size_t const numIndexes,
-                                       std::size_t const offset,
-                                       std::size_t const skip)
+    auto const numInputsLeft = numInputs / 2u;
+    auto const numInputsRight = numInputs - numInputsLeft;
+    emitDivideAndConquerSort(scheduler, numInputsLeft, offset, leaves);
+    emitDivideAndConquerSort(scheduler,
+                             numInputsRight,
+                             offset + numInputsLeft,
+                             leaves);
+    Detail::emitOddEvenMerger(scheduler,
+                              numInputsLeft,
+                              offset,
+                              1u,
+                              numInputsRight,
+                              offset + numInputsLeft,
+                              1u);
+}
+
+/**
+  Emits a network which outputs the numSelected smallest of its inputs in
+  ascending order on its first numSelected lines, where parts with at most
+  numSelected inputs are sorted by emitDivideAndConquerSort().
+*/
+void emitSelection(StageScheduler & scheduler,
+                   std::size_t numInputs,
+                   std::size_t numSelected,
+                   std::size_t offset,
+                   std::vector<Network> const & leaves)
 {
-    for (std::size_t i = 1u; i < numIndexes; i += 2u) {
-        auto const b = offset + (i * skip);
-        assert(b < n.numInputs());
-        auto const a = b - skip;
-        assert(a < n.numInputs());
-        n.composeWith(Comparator(a, b));
+    if (numInputs <= numSelected) {
+        emitDivideAndConquerSort(scheduler, numInputs, offset, leaves);
+        return;
     }
-    std::list<StrideJob> jobs;
-    if (numIndexes <= 2)
-        return jobs;
-
-    {
-        /* Sort "pairs" recursively. Like with odd-even mergesort, odd and even
-           lines are handled recursively and later reunited. */
-
-        /* Recursive call #1 with first set of lines */
-        auto const numOddIndexes = numIndexes / 2u;
-        auto const numEvenIndexes = numIndexes - numOddIndexes;
-        jobs.emplace_back(StrideJob{numEvenIndexes, offset, skip * 2u, true});
-
-        /* Recursive call #2 with second set of lines */
-        jobs.emplace_back(
-                    StrideJob{numOddIndexes, offset + skip, skip * 2u, true});
+    auto const numInputsLeft = numInputs / 2u;
+    auto const numInputsRight = numInputs - numInputsLeft;
+    auto const numSelectedLeft = std::min(numSelected, numInputsLeft);
+    auto const numSelectedRight = std::min(numSelected, numInputsRight);
+    emitSelection(scheduler, numInputsLeft, numSelected, offset, leaves);
+    emitSelection(scheduler,
+                  numInputsRight,
+                  numSelected,
+                  offset + numInputsLeft,
+                  leaves);
+    /* If numSelectedLeft < numSelected, then numSelectedLeft = numInputsLeft,
+       so the first numSelected lines of the merged sequence are contiguous: */
+    Detail::emitOddEvenMerger(scheduler,
+                              numSelectedLeft,
+                              offset,
+                              1u,
+                              numSelectedRight,
+                              offset + numInputsLeft,
+                              1u);
+}
+
+/**
+  \returns the leaf networks for emitDivideAndConquerSort(), indexed by their
+           numbers of inputs. The parts after k halvings have
+           floor(numInputs / 2^k) or ceil(numInputs / 2^k) inputs, hence only
+           the leaves of these sizes are made and the other leaves are empty.
+*/
+std::vector<Network> makeLeaves(std::size_t numInputs,
+                                std::size_t leafSize,
+                                Objective leafObjective)
+{
+    std::vector<Network> leaves;
+    leaves.reserve(leafSize + 1u);
+    for (std::size_t i = 0u; i <= leafSize; ++i)
+        leaves.emplace_back(i);
+    auto minSize = numInputs;
+    auto maxSize = numInputs;
+    for (;;) {
+        if (minSize <= leafSize)
+            leaves[minSize] = Network::makeBestKnown(minSize, leafObjective);
+        if (maxSize <= leafSize) {
+            leaves[maxSize] = Network::makeBestKnown(maxSize, leafObjective);
+            break;
+        }
+        minSize /= 2u;
+        maxSize -= maxSize / 2u;
     }
-    jobs.emplace_back(StrideJob{numIndexes, offset, skip, false});
-    return jobs;
+    return leaves;
 }
 
-template <typename Conquer>
-Network makeSortWithDivideAndConquer(std::size_t numInputs, Conquer & conquer) {
-    if (numInputs <= 2u) {
-        if (numInputs == 2u) {
-            Network n(2u);
-            n.composeWith(Comparator(0u, 1u));
-            return n;
+/**
+  \returns the stages of two networks executed side by side, where the lines
+           of the second network follow the lines of the first one.
+*/
+Network::Stages joinStages(Network::Stages const & stages,
+                           Network::Stages const & otherStages,
+                           std::size_t const otherOffset)
+{
+    auto const numStages = std::max(stages.size(), otherStages.size());
+    Network::Stages r;
+    r.reserve(numStages);
+    for (std::size_t i = 0u; i < numStages; ++i) {
+        Stage::Comparators comparators;
+        if (i < stages.size())
+            comparators = stages[i].comparators();
+        if (i < otherStages.size()) {
+            auto const & otherComparators = otherStages[i].comparators();
+            comparators.reserve(comparators.size() + otherComparators.size());
+            for (auto const & comp : otherComparators)
+                comparators.emplace_back(comp.min() + otherOffset,
+                                         comp.max() + otherOffset);
         }
-        return Network(numInputs);
+        // Already sorted, since all lines of the other network come later:
+        r.emplace_back(std::move(comparators));
     }
-
-    // Use a stack machine instead of recursion:
-    enum DivideAndConquerOp : char { Recurse, ConquerOneDouble, ConquerTwo };
-    std::vector<Network> networkStack; // arguments for conquer
-    std::vector<DivideAndConquerOp> operationStack;
-    operationStack.emplace_back(Recurse);
-    std::vector<std::size_t> argumentStack; // arguments for creating networks
-    argumentStack.emplace_back(numInputs);
-
-    do {
-        auto const operation(operationStack.back());
-        operationStack.pop_back();
-        if (operation == Recurse) {
-            assert(!argumentStack.empty());
-            numInputs = argumentStack.back();
-            argumentStack.pop_back();
-            if (numInputs <= 1u) {
-                networkStack.emplace_back(numInputs);
-            } else if (numInputs == 2u) {
-                networkStack.emplace_back(numInputs);
-                networkStack.back().composeWith(Comparator(0u, 1u));
-            } else {
-                auto const numInputsLeft = numInputs / 2u;
-                auto const numInputsRight = numInputs - numInputsLeft;
-                if (numInputsLeft == numInputsRight) {
-                    argumentStack.emplace_back(numInputsLeft);
-                    operationStack.emplace_back(ConquerOneDouble);
-                    operationStack.emplace_back(Recurse);
-                } else {
-                    argumentStack.emplace_back(numInputsLeft);
-                    argumentStack.emplace_back(numInputsRight);
-                    operationStack.emplace_back(ConquerTwo);
-                    operationStack.emplace_back(Recurse);
-                    operationStack.emplace_back(Recurse);
-                }
-            }
-        } else if (operation == ConquerOneDouble) {
-            assert(!networkStack.empty());
-            networkStack.back() = conquer(networkStack.back(),
-                                          networkStack.back());
-            networkStack.back().compress();
-        } else {
-            assert(operation == ConquerTwo);
-            assert(networkStack.size() >= 2u);
-            {
-                auto const firstArg(std::move(networkStack.back()));
-                networkStack.pop_back();
-                networkStack.back() = conquer(firstArg, networkStack.back());
-            }
-            networkStack.back().compress();
-        }
-    } while (!operationStack.empty());
-    assert(argumentStack.empty());
-    assert(networkStack.size() == 1u);
-    return std::move(networkStack.front());
+    return r;
 }
 
 } // anonymous namespace
@@ -355,45 +526,128 @@ void Network::addInputs(std::size_t numInputsToAdd) {
     m_numInputs += numInputsToAdd;
 }
 
-Network Network::makeOddEvenMergeSort(std::size_t numInputs)
-{ return makeSortWithDivideAndConquer(numInputs, combineOddEvenMerge_); }
-
-Network Network::makeBitonicMergeSort(std::size_t numInputs)
-{ return makeSortWithDivideAndConquer(numInputs, combineBitonicMerge_); }
+Network Network::makeOddEvenMergeSort(std::size_t numInputs) {
+    if (isPowerOfTwo(numInputs))
+        return makePowerOfTwoNetwork(
+                    numInputs,
+                    [](std::size_t n, std::size_t stage, auto && f)
+                    { forEachOddEvenMergeSortComparator(n, stage, f); });
+    return makeScheduledNetwork(
+                numInputs,
+                [numInputs](StageScheduler & scheduler)
+                { Detail::emitOddEvenMergeSort(scheduler, numInputs, 0u); });
+}
+
+Network Network::makeBitonicMergeSort(std::size_t numInputs) {
+    if (isPowerOfTwo(numInputs))
+        return makePowerOfTwoNetwork(
+                    numInputs,
+                    [](std::size_t n, std::size_t stage, auto && f)
+                    { forEachBitonicMergeSortComparator(n, stage, f); });
+    return makeScheduledNetwork(
+                numInputs,
+                [numInputs](StageScheduler & scheduler) {
+                    Detail::emitBitonicMergeSort(scheduler,
+                                                 numInputs,
+                                                 0u,
+                                                 false);
+                });
+}
 
 Network Network::makePairwiseSort(std::size_t numInputs) {
-    Network n(numInputs);
-    auto jobs(pairwiseRecursive(n, numInputs, 0u, 1u));
-    while (!jobs.empty()) {
-        StrideJob job(std::move(jobs.front()));
-        jobs.pop_front();
-        if (job.m_isRecursive) {
-            jobs.splice(jobs.begin(),
-                        pairwiseRecursive(n, job.m_numIndexes, job.m_offset, job.m_skip));
-        } else {
-            /* m is the "amplitude" of the sorted pairs. This is a bit tricky to read
-               due to different indices being used in the paper, unfortunately. */
-            auto m = (job.m_numIndexes + 1u) / 2u;
-            while (m > 1u) {
-                auto len = m;
-                if ((m % 2u) == 0)
-                    --len;
-
-                for (std::size_t i = 1u; i + len < job.m_numIndexes; i += 2u) {
-                    auto const left = job.m_offset + (i * job.m_skip);
-                    assert(left < n.numInputs());
-                    auto const right = job.m_offset + ((i + len) * job.m_skip);
-                    assert(left < right);
-                    assert(right < n.numInputs());
-                    n.composeWith(Comparator(left, right));
-                }
-
-                m = (m + 1u) / 2u;
-            } /* while (m > 1u) */
-        }
+    if (isPowerOfTwo(numInputs))
+        return makePowerOfTwoNetwork(
+                    numInputs,
+                    [](std::size_t n, std::size_t stage, auto && f)
+                    { forEachPairwiseSortComparator(n, stage, f); });
+    return makeScheduledNetwork(
+                numInputs,
+                [numInputs](StageScheduler & scheduler)
+                { Detail::emitPairwiseSort(scheduler, numInputs, 0u, 1u); });
+}
+
+Network Network::make(Algorithm algorithm, std::size_t numInputs) {
+    switch (algorithm) {
+    case Algorithm::OddEvenMergeSort:
+        return makeOddEvenMergeSort(numInputs);
+    case Algorithm::BitonicMergeSort:
+        return makeBitonicMergeSort(numInputs);
+    case Algorithm::PairwiseSort:
+        return makePairwiseSort(numInputs);
     }
-    n.compress();
-    return n;
+    assert(false);
+    return Network(numInputs);
+}
+
+Network Network::makeSortWithDivideAndConquer(std::size_t numInputs,
+                                              std::size_t leafSize,
+                                              Objective leafObjective)
+{
+    leafSize = std::max(std::min(leafSize, numInputs), std::size_t(1u));
+    auto const leaves(makeLeaves(numInputs, leafSize, leafObjective));
+    return makeScheduledNetwork(
+                numInputs,
+                [numInputs, &leaves](StageScheduler & scheduler) {
+                    emitDivideAndConquerSort(scheduler,
+                                             numInputs,
+                                             0u,
+                                             leaves);
+                });
+}
+
+Network Network::makeSelectionNetwork(std::size_t numInputs,
+                                      std::size_t numSelected)
+{
+    numSelected = std::min(numSelected, numInputs);
+    if (!numSelected)
+        return Network(numInputs);
+    auto const leafSize = std::min(numSelected, std::size_t(16u));
+    auto const leaves(makeLeaves(numInputs, leafSize, Objective::Size));
+    auto r(makeScheduledNetwork(
+               numInputs,
+               [numInputs, numSelected, &leaves](StageScheduler & scheduler) {
+                   emitSelection(scheduler,
+                                 numInputs,
+                                 numSelected,
+                                 0u,
+                                 leaves);
+               }));
+    std::vector<std::size_t> outputs(numSelected);
+    for (std::size_t i = 0u; i < numSelected; ++i)
+        outputs[i] = i;
+    r.pruneToOutputs(outputs);
+    return r;
+}
+
+Network Network::makeOddEvenMerger(std::size_t numLeftInputs,
+                                   std::size_t numRightInputs)
+{
+    if (std::numeric_limits<std::size_t>::max() - numLeftInputs
+        < numRightInputs)
+        throw std::length_error("Resulting comparator network exceeds "
+                                "implementation limits!");
+    return makeScheduledNetwork(
+                numLeftInputs + numRightInputs,
+                [numLeftInputs, numRightInputs](StageScheduler & scheduler) {
+                    Detail::emitOddEvenMerger(scheduler,
+                                              numLeftInputs,
+                                              0u,
+                                              1u,
+                                              numRightInputs,
+                                              numLeftInputs,
+                                              1u);
+                });
+}
+
+Network Network::makeBitonicMerger(std::size_t numInputs) {
+    return makeScheduledNetwork(
+                numInputs,
+                [numInputs](StageScheduler & scheduler) {
+                    Detail::emitBitonicRunMerger(scheduler,
+                                                 numInputs / 2u,
+                                                 numInputs - numInputs / 2u,
+                                                 0u);
+                });
 }
 
 Network::~Network() noexcept = default;
@@ -411,22 +665,8 @@ std::size_t Network::numComparators() const noexcept {
 void Network::joinWith(Network const & other) {
     auto const oldNumInputs = m_numInputs;
     addInputs(other.m_numInputs);
-    auto const oldNumStages = m_stages.size();
     try {
-        m_stages.resize(std::max(oldNumStages, other.m_stages.size()));
-        try {
-            auto stageIt(m_stages.begin());
-            for (auto const & stage : other.m_stages) {
-                for (auto const & comp : stage.comparators())
-                    stageIt->addComparator(
-                                Comparator(comp.min() + oldNumInputs,
-                                           comp.max() + oldNumInputs));
-                ++stageIt;
-            }
-        } catch (...) {
-            m_stages.resize(oldNumStages);
-            throw;
-        }
+        m_stages = joinStages(m_stages, other.m_stages, oldNumInputs);
     } catch (...) {
         m_numInputs = oldNumInputs;
         throw;
@@ -435,34 +675,35 @@ void Network::joinWith(Network const & other) {
 
 Network Network::joinedWith(Network other) const {
     other.addInputs(m_numInputs);
-    auto const oldNumStages = other.m_stages.size();
-    other.shift(m_numInputs);
-    other.m_stages.resize(std::max(oldNumStages, m_stages.size()));
-    auto stageIt(other.m_stages.begin());
-    for (auto const & stage : m_stages) {
-        for (auto const & comp : stage.comparators())
-            stageIt->addComparator(comp);
-        ++stageIt;
-    }
+    other.m_stages = joinStages(m_stages, other.m_stages, m_numInputs);
     return other;
 }
 
-void Network::composeWith(Network && other) {
-    auto const oldSize = m_stages.size();
-    try {
-        for (auto & otherStage : other.m_stages)
-            m_stages.emplace_back(std::move(otherStage));
-    } catch (...) {
-        m_stages.resize(oldSize);
-        throw;
+void Network::composeWith(Network && other)
+{ composeWithStages(std::move(other.m_stages)); }
+
+void Network::composeWith(Network const & other)
+{ composeWithStages(other.m_stages); }
+
+void Network::composeWithStages(Stages && stages) {
+    if (m_stages.empty()) {
+        m_stages = std::move(stages);
+        return;
     }
+    m_stages.back().clearLineIndex();
+    m_stages.reserve(m_stages.size() + stages.size());
+    for (auto & stage : stages)
+        m_stages.emplace_back(std::move(stage));
 }
 
-void Network::composeWith(Network const & other) {
+void Network::composeWithStages(Stages const & stages) {
+    if (!m_stages.empty())
+        m_stages.back().clearLineIndex();
     auto const oldSize = m_stages.size();
+    m_stages.reserve(oldSize + stages.size());
     try {
-        for (auto & otherStage : other.m_stages)
-            m_stages.emplace_back(otherStage);
+        for (auto const & stage : stages)
+            m_stages.emplace_back(stage);
     } catch (...) {
         m_stages.resize(oldSize);
         throw;
@@ -470,6 +711,8 @@ void Network::composeWith(Network const & other) {
 }
 
 Stage & Network::composeWithEmptyStage() {
+    if (!m_stages.empty())
+        m_stages.back().clearLineIndex();
     #if __cplusplus >= 201703L
     return m_stages.emplace_back();
     #else
@@ -479,6 +722,8 @@ Stage & Network::composeWithEmptyStage() {
 }
 
 Stage & Network::composeWith(Stage && stage) {
+    if (!m_stages.empty())
+        m_stages.back().clearLineIndex();
     #if __cplusplus >= 201703L
     return m_stages.emplace_back(std::move(stage));
     #else
@@ -488,6 +733,8 @@ Stage & Network::composeWith(Stage && stage) {
 }
 
 Stage & Network::composeWith(Stage const & stage) {
+    if (!m_stages.empty())
+        m_stages.back().clearLineIndex();
     #if __cplusplus >= 201703L
     return m_stages.emplace_back(stage);
     #else
@@ -503,13 +750,20 @@ void Network::removeStage(std::size_t index) {
 }
 
 void Network::composeWith(Comparator comparator) {
+    /* Only the last stage keeps a line index, which is built on demand and
+       released when a new stage is started: */
     if (!m_stages.empty()) {
         Stage & lastStage = m_stages.back();
+        if (!lastStage.hasLineIndex())
+            lastStage.buildLineIndex();
         if (lastStage.getConflictsWith(comparator) == Stage::NoConflict)
             return lastStage.addComparator(std::move(comparator));
+        lastStage.clearLineIndex();
     }
 
-    composeWithEmptyStage().addComparator(std::move(comparator));
+    auto & stage = composeWithEmptyStage();
+    stage.buildLineIndex();
+    stage.addComparator(std::move(comparator));
 }
 
 void Network::invert() noexcept {
@@ -533,47 +787,49 @@ void Network::shift(std::size_t offset) noexcept {
 void Network::compress() {
     if (m_stages.empty())
         return;
-    for (auto stageIt = std::next(m_stages.begin(), 1);
-         stageIt != m_stages.end();
-         ++stageIt)
-    {
-        auto & comps = stageIt->comparators();
-        for (std::size_t i = 0u; i < comps.size(); ++i) {
-            auto targetStageIt(stageIt);
-            for (auto prevStageIt = std::prev(stageIt, 1);; --prevStageIt) {
-                auto const conflict =
-                        prevStageIt->getConflictsWith(comps[i]);
-                if (conflict == Stage::NoConflict) {
-                    targetStageIt = prevStageIt;
-                } else {
-                    if (conflict == Stage::ComparatorAlreadyPresent)
-                        targetStageIt = m_stages.end();
-                    break;
-                }
-
-                if (prevStageIt == m_stages.begin())
-                    break;
-            }
-            if (targetStageIt != stageIt) {
-                if (targetStageIt != m_stages.end()) {
-                    assert(targetStageIt->getConflictsWith(comps[i])
-                           == Stage::NoConflict);
-                    targetStageIt->addComparator(std::move(comps[i]));
-                }
-                stageIt->removeComparator(i);
-                --i;
-            }
-        }
+    std::size_t numLines = m_numInputs;
+    for (auto const & stage : m_stages)
+        for (auto const & comparator : stage.comparators())
+            numLines = std::max(numLines,
+                                std::max(comparator.min(), comparator.max())
+                                + 1u);
+    m_stages = scheduleStages(numLines,
+                              [this](StageScheduler & scheduler)
+                              { addComparators(scheduler, m_stages, 0u); });
+}
+
+void Network::pruneToOutputs(std::vector<std::size_t> const & outputs) {
+    std::vector<bool> needed(m_numInputs, false);
+    for (auto const output : outputs) {
+        assert(output < m_numInputs);
+        needed[output] = true;
     }
-
-    // Remove all empty stages:
-    for (std::size_t i = 0u; i < m_stages.size(); ++i) {
-        if (m_stages[i].empty()) {
-            m_stages.erase(std::next(m_stages.begin(),
-                                     static_cast<Stages::difference_type>(i)));
-            --i;
-        }
+    Stage::Comparators kept;
+    for (auto i = m_stages.size(); i--;) {
+        auto const & comparators = m_stages[i].comparators();
+        kept.clear();
+        for (auto const & comparator : comparators)
+            if (needed[comparator.min()] || needed[comparator.max()])
+                kept.emplace_back(comparator);
+        // The lines of a stage are distinct, so this can be done afterwards:
+        for (auto const & comparator : kept)
+            needed[comparator.min()] = needed[comparator.max()] = true;
+        if (kept.size() != comparators.size())
+            m_stages[i] = Stage(kept);
     }
+    m_stages.erase(std::remove_if(m_stages.begin(),
+                                  m_stages.end(),
+                                  [](Stage const & stage)
+                                  { return stage.empty(); }),
+                   m_stages.end());
+}
+
+Network Network::prunedToOutputs(std::vector<std::size_t> const & outputs)
+        const
+{
+    Network n(*this);
+    n.pruneToOutputs(outputs);
+    return n;
 }
 
 Network Network::compressed() const {
@@ -639,20 +895,6 @@ Network combineOddEvenMerge(Network const & n0, Network const & n1) {
     return combineOddEvenMerge_(n0, n1);
 }
 
-bool Network::bruteForceIsSortingNetwork() const {
-    std::vector<std::size_t> sorted(m_numInputs);
-    for (std::size_t i = 0u; i < m_numInputs; ++i)
-        sorted[i] = i;
-    auto maybeUnsorted(sorted);
-    do {
-        auto test(maybeUnsorted);
-        sortValues(test.data());
-        if (test != sorted)
-            return false;
-    } while (std::next_permutation(maybeUnsorted.begin(), maybeUnsorted.end()));
-    return true;
-}
-
 int Network::compare(Network const & other) const noexcept {
     if (m_numInputs != other.m_numInputs)
         return (m_numInputs < other.m_numInputs) ? -1 : 1;
@@ -26,11 +26,18 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <iterator>
+#include <limits>
 #include <sharemind/Concepts.h>
 #include <sharemind/Iterator.h>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
+#include "Algorithm.h"
 #include "Comparator.h"
+#include "Exchange.h"
 #include "Stage.h"
 
 
@@ -75,6 +82,86 @@ public: /* Methods: */
     */
     static Network makePairwiseSort(std::size_t numInputs);
 
+    /**
+      Creates a new sorting network using the given algorithm.
+      \param[in] algorithm The algorithm to generate the network with.
+      \param[in] numInputs The number of inputs to sort.
+    */
+    static Network make(Algorithm algorithm, std::size_t numInputs);
+
+    /**
+      Creates the sorting network with the fewest comparators (Objective::Size)
+      or stages (Objective::Depth) known to this library, with ties broken by
+      the other property. For up to 16 inputs, the networks are taken from
+      tables of the best known size-optimal and depth-optimal networks. Larger
+      networks are not necessarily the best known ones: for 17 to 32 inputs,
+      the networks are derived by merging two smaller networks made by this
+      function with combineOddEvenMerge() using the best split. If no such
+      network is better or for more than 32 inputs, the best network generated
+      by makeOddEvenMergeSort(), makeBitonicMergeSort() or makePairwiseSort()
+      is returned.
+      \param[in] numInputs The number of inputs to sort.
+      \param[in] objective The property to minimize.
+    */
+    static Network makeBestKnown(std::size_t numInputs,
+                                 Objective objective = Objective::Size);
+
+    /**
+      Creates a new sorting network by splitting the inputs into halves
+      recursively until at most leafSize inputs remain, sorting these with the
+      networks made by makeBestKnown() and merging the halves with Batcher's
+      Odd-Even-Merger. Best known networks are only tabulated for up to 16
+      inputs. Leaves of 17 to 32 inputs are derived by makeBestKnown() with
+      combineOddEvenMerge() too, but using the best split instead of halves,
+      which may save a few comparators or stages. Larger leaves bring no
+      benefit.
+      \param[in] numInputs The number of inputs to sort.
+      \param[in] leafSize The maximum number of inputs of the leaves.
+      \param[in] leafObjective Whether the leaves minimize the number of
+                               comparators or the number of stages.
+    */
+    static Network makeSortWithDivideAndConquer(
+            std::size_t numInputs,
+            std::size_t leafSize = 16u,
+            Objective leafObjective = Objective::Size);
+
+    /**
+      Creates a new selection network, which outputs the numSelected smallest
+      of its inputs in ascending order on its first numSelected lines. The
+      remaining inputs are output on the other lines in an unspecified order.
+      The inputs are split into halves recursively, the numSelected smallest
+      values of both halves are selected recursively and merged with Batcher's
+      Odd-Even-Merger, and parts with at most numSelected inputs are sorted as
+      by makeSortWithDivideAndConquer(). Finally, the network is pruned to the
+      first numSelected outputs with pruneToOutputs().
+      \param[in] numInputs The number of inputs.
+      \param[in] numSelected The number of smallest values to select.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    static Network makeSelectionNetwork(std::size_t numInputs,
+                                        std::size_t numSelected);
+
+    /**
+      Creates a new network merging a sorted sequence of numLeftInputs values
+      followed by a sorted sequence of numRightInputs values using Batcher's
+      Odd-Even-Merger. This is the merger added by combineOddEvenMerge().
+      \param[in] numLeftInputs The number of values in the first sequence.
+      \param[in] numRightInputs The number of values in the second sequence.
+      \throws std::length_error if the resulting network exceeds implementation
+                                limits.
+    */
+    static Network makeOddEvenMerger(std::size_t numLeftInputs,
+                                     std::size_t numRightInputs);
+
+    /**
+      Creates a new network merging a sorted sequence of numInputs / 2 values
+      followed by a sorted sequence of the remaining values using a bitonic
+      merger. Unlike the merger added by combineBitonicMerge(), both sequences
+      are sorted in ascending order.
+      \param[in] numInputs The total number of values to merge.
+    */
+    static Network makeBitonicMerger(std::size_t numInputs);
+
     ~Network() noexcept;
 
     Network & operator=(Network &&) noexcept;
@@ -142,6 +229,18 @@ public: /* Methods: */
     */
     void composeWith(Network const & network);
 
+    /**
+      Composes this network with the given stages, in order.
+      \param[in] stages The stages to be composed to this network.
+    */
+    void composeWithStages(Stages && stages);
+
+    /**
+      Composes this network with the given stages, in order.
+      \param[in] stages The stages to be composed to this network.
+    */
+    void composeWithStages(Stages const & stages);
+
     /**
       Composes this network with a new empty stage.
       \returns a reference to the newly added stage.
@@ -237,9 +336,152 @@ public: /* Methods: */
             stage.sortValues<It, Comp &>(first, comp);
     }
 
+    /**
+      Applies a comparator network to the given array of values using the given
+      exchange policy, e.g. BranchFreeExchange to avoid branching on the results
+      of the comparisons, and operator<() for comparisons.
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network.
+      \param[in] first Iterator to the first value to sort.
+      \param[in] exchange The exchange policy (see Exchange.h), callable as
+                          exchange(first[i], first[j], doSwap) for any valid i
+                          and j, which must swap its first two arguments if and
+                          only if doSwap is true.
+     */
+    template <typename It,
+              typename Exchange,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type)),
+              typename std::enable_if<
+                    Detail::IsExchangePolicy<
+                            Exchange,
+                            typename std::iterator_traits<It>::value_type
+                    >::value,
+                    int>::type = 0>
+    void sortValues(It first, Exchange exchange) const {
+        for (auto const & stage : m_stages)
+            stage.sortValues<It, Exchange &>(first, exchange);
+    }
+
+    /**
+      Applies a comparator network to the given array of values using the given
+      exchange policy, e.g. BranchFreeExchange to avoid branching on the results
+      of the comparisons.
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network.
+      \param[in] first Iterator to the first value to sort.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+      \param[in] exchange The exchange policy (see Exchange.h), callable as
+                          exchange(first[i], first[j], doSwap) for any valid i
+                          and j, which must swap its first two arguments if and
+                          only if doSwap is true.
+     */
+    template <typename It,
+              typename Comp,
+              typename Exchange,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValues(It first, Comp comp, Exchange exchange) const {
+        for (auto const & stage : m_stages)
+            stage.sortValues<It, Comp &, Exchange &>(first, comp, exchange);
+    }
+
+    /**
+      Applies this comparator network to a batch of equal-length arrays stored
+      in a transposed (lane) layout, i.e. the j-th value of the i-th array is
+      stored at first[j * batchSize + i] (see toLaneLayout()).
+      \param[in] first Iterator to the first value of the batch.
+      \param[in] batchSize The number of arrays in the batch.
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network times batchSize.
+     */
+    template <typename It,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValuesBatch(It first, std::size_t batchSize) const {
+        for (auto const & stage : m_stages)
+            stage.sortValuesBatch(first, batchSize);
+    }
+
+    /**
+      Applies this comparator network to a batch of equal-length arrays stored
+      in a transposed (lane) layout, i.e. the j-th value of the i-th array is
+      stored at first[j * batchSize + i] (see toLaneLayout()).
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network times batchSize.
+      \param[in] first Iterator to the first value of the batch.
+      \param[in] batchSize The number of arrays in the batch.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+     */
+    template <typename It,
+              typename Comp,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValuesBatch(It first, std::size_t batchSize, Comp comp) const {
+        for (auto const & stage : m_stages)
+            stage.sortValuesBatch<It, Comp &>(first, batchSize, comp);
+    }
+
+    /**
+      Executes this network stage by stage via a user-provided stage executor.
+      For each stage, the executor is called with pointers to an array of the
+      32-bit minimum line indexes and to an array of the 32-bit maximum line
+      indexes of the comparators of that stage (see Stage::exportIndexes()),
+      and the number of comparators in the stage. The index type is the same
+      as CompiledNetwork::Index, so the same executor can be used with
+      CompiledNetwork::executeStages().
+      \param[in] executor The stage executor, callable as
+                          executor(std::uint32_t const * minIndexes,
+                                   std::uint32_t const * maxIndexes,
+                                   std::size_t numComparators).
+      \throws std::length_error if this network has more than 2^32 inputs.
+      \note The index arrays are rebuilt for every stage on each call. For
+            repeated execution, consider CompiledNetwork::executeStages().
+    */
+    template <typename StageExecutor>
+    void executeStages(StageExecutor && executor) const {
+        if (m_numInputs > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("Number of inputs exceeds implementation "
+                                    "limits!");
+        std::vector<std::uint32_t> minIndexes;
+        std::vector<std::uint32_t> maxIndexes;
+        for (auto const & stage : m_stages) {
+            auto const numComparators = stage.numComparators();
+            minIndexes.resize(numComparators);
+            maxIndexes.resize(numComparators);
+            stage.exportIndexes(minIndexes.begin(), maxIndexes.begin());
+            executor(static_cast<std::uint32_t const *>(minIndexes.data()),
+                     static_cast<std::uint32_t const *>(maxIndexes.data()),
+                     numComparators);
+        }
+    }
+
     /**
       Compresses this network by moving all comparators to the earliest possible
-      stage and removing all remaining empty stages.
+      stage and removing all remaining empty stages. A comparator is removed if
+      the latest stage touching either of its lines already contains the same
+      comparator.
+      \note This takes time linear in the number of comparators.
     */
     void compress();
 
@@ -249,6 +491,45 @@ public: /* Methods: */
     */
     Network compressed() const;
 
+    /**
+      Removes all comparators which cannot affect the given outputs, i.e. walks
+      the stages backwards and keeps only the comparators touching a line
+      which the given outputs or the comparators kept so far depend on, and
+      removes all stages left empty.
+      \param[in] outputs The indexes of the outputs to keep.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    void pruneToOutputs(std::vector<std::size_t> const & outputs);
+
+    /**
+      Returns a copy of this network on which pruneToOutputs() has been called.
+      \param[in] outputs The indexes of the outputs to keep.
+      \returns A pruned version of this network.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    Network prunedToOutputs(std::vector<std::size_t> const & outputs) const;
+
+    /**
+      Removes all comparators which never swap their values for any input and
+      compresses this network. For networks with up to 64 inputs, the sets of
+      0-1-patterns reachable before each stage are tracked as by
+      isSortingNetwork(), which finds all such comparators unless the sets grow
+      too large. Otherwise, and for up to 8192 inputs, the pairs of lines whose
+      values are known to be ordered are tracked instead, which finds
+      comparators made redundant by earlier comparators, e.g. repeated ones.
+      Larger networks are only compressed.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    void removeRedundantComparators();
+
+    /**
+      Returns a copy of this network on which removeRedundantComparators() has
+      been called.
+      \returns A version of this network without redundant comparators.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    Network withoutRedundantComparators() const;
+
     /**
       Converts a non-standard network to a standard network, i.e. a network in
       which all comparators point in the same direction.
@@ -280,14 +561,60 @@ public: /* Methods: */
     */
     void removeInput(std::size_t index);
 
+    /**
+      Writes this network to a stream in the versioned binary format described
+      in NetworkFormat.h. Line indexes are stored in two bytes if this network
+      has at most 65536 inputs and in four bytes otherwise. Failures to write
+      are reported by the state of the stream.
+      \param[in] out The output stream, which should be in binary mode.
+      \throws std::length_error if this network has more than 2^32 inputs.
+    */
+    void save(std::ostream & out) const;
+
+    /**
+      Reads a network written by save() from a stream.
+      \param[in] in The input stream, which should be in binary mode.
+      \returns the network read.
+      \throws InvalidNetworkFormat (see NetworkFormat.h) if the data read is
+                                   truncated, corrupt or not a valid network.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    static Network load(std::istream & in);
+
     /**
       Checks whether a this network is a sorting network by testing all
-      \f$ 2^n \f$ 0-1-patterns. Since this function has exponential running
-      time, using it with comparator networks with many inputs is not advisable.
+      \f$ 2^n \f$ 0-1-patterns, which suffices by the 0-1-principle. The
+      patterns are evaluated bit-parallel, 512 at a time, and split between
+      threads. Since this function has exponential running time, using it with
+      comparator networks with more than about 32 inputs is not advisable.
+      \param[in] numThreads The number of threads to use, including the calling
+                            thread. If zero, the number of hardware threads is
+                            used. Fewer threads are used for small networks.
+      \returns whether this network is a sorting network.
+      \throws std::length_error if this network has 64 or more inputs.
+      \throws std::system_error if a thread could not be started.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+     */
+    bool bruteForceIsSortingNetwork(std::size_t numThreads = 0u) const;
+
+    /**
+      Checks whether a this network is a sorting network by propagating the
+      sets of 0-1-patterns reachable after each stage. Lines not yet connected
+      by comparators are kept in separate components whose sets are only
+      combined when a comparator connects them, duplicate patterns are removed
+      after every stage, and if this network equals its reflection, only one
+      pattern of every reflected pair is kept. This is much faster than
+      bruteForceIsSortingNetwork() for good sorting networks, whose sets stay
+      small, e.g. networks with up to about 40 inputs.
+      \param[in] maxSetSize The maximum number of patterns to keep in memory
+                            for any component. Larger sets are split into parts
+                            which are verified one after another. If zero, a
+                            default of \f$ 2^{24} \f$ patterns is used.
       \returns whether this network is a sorting network.
+      \throws std::length_error if this network has more than 64 inputs.
       \throws std::bad_alloc an out-of-memory condition was encountered.
      */
-    bool bruteForceIsSortingNetwork() const;
+    bool isSortingNetwork(std::size_t maxSetSize = 0u) const;
 
     /**
       Compares this network with another and returns zero if they are equal. If
@@ -345,6 +672,30 @@ Network combineBitonicMerge(Network const & n0, Network const & n1);
  */
 Network combineOddEvenMerge(Network const & n0, Network const & n1);
 
+/**
+  Checks whether a comparator network merges any sorted sequence of n0 values
+  on its first n0 lines with any sorted sequence of n1 values on its last n1
+  lines. By the 0-1-principle, it suffices to test the
+  \f$ (n_0 + 1)(n_1 + 1) \f$ such 0-1-patterns, which are evaluated
+  bit-parallel, 512 at a time, and split between threads. Hence this is
+  feasible for mergers with thousands of inputs.
+  \pre n0 + n1 must be equal to the number of inputs of the network.
+  \param[in] network The network to check.
+  \param[in] n0 The number of values in the first sorted sequence.
+  \param[in] n1 The number of values in the second sorted sequence.
+  \param[in] numThreads The number of threads to use, including the calling
+                        thread. If zero, the number of hardware threads is
+                        used. Fewer threads are used for small networks.
+  \returns whether the network is a merging network.
+  \throws std::length_error if n0 or n1 exceeds 2^32 - 1.
+  \throws std::system_error if a thread could not be started.
+  \throws std::bad_alloc an out-of-memory condition was encountered.
+ */
+bool isMergingNetwork(Network const & network,
+                      std::size_t n0,
+                      std::size_t n1,
+                      std::size_t numThreads = 0u);
+
 } /* namespace SortingNetwork { */
 } /* namespace sharemind { */
 
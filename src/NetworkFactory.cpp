@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#include "NetworkFactory.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <utility>
+
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace {
+
+std::size_t estimateMemoryUsage(Network const & network) noexcept {
+    auto r = sizeof(Network) + network.stages().capacity() * sizeof(Stage);
+    for (auto const & stage : network.stages())
+        r += stage.comparators().capacity() * sizeof(Comparator);
+    return r;
+}
+
+std::size_t estimateMemoryUsage(CompiledNetwork const & network) noexcept {
+    return sizeof(CompiledNetwork)
+           + (network.numStages() + 1u + 2u * network.numComparators())
+             * sizeof(CompiledNetwork::Index);
+}
+
+} // anonymous namespace
+
+struct NetworkFactory::Inner {
+
+/* Types: */
+
+    struct Key {
+        bool operator<(Key const & rhs) const noexcept {
+            return std::tie(algorithm, numInputs, transformations, compiled)
+                   < std::tie(rhs.algorithm,
+                              rhs.numInputs,
+                              rhs.transformations,
+                              rhs.compiled);
+        }
+
+        Algorithm algorithm;
+        std::size_t numInputs;
+        unsigned transformations;
+        bool compiled;
+    };
+
+    /** Either the network or the compiled network, depending on the key: */
+    struct Value {
+        std::shared_ptr<Network const> network;
+        std::shared_ptr<CompiledNetwork const> compiledNetwork;
+    };
+
+    struct Entry {
+        std::shared_future<Value> value;
+
+        /** The tick of the last use, updated under a shared lock: */
+        std::atomic<std::uint64_t> lastUsed{0u};
+
+        /** Whether the value is ready, i.e. whether this entry is evictable: */
+        bool ready = false;
+        std::size_t memoryUsage = 0u;
+    };
+
+/* Methods: */
+
+    explicit Inner(std::size_t memoryLimit) noexcept
+        : m_memoryLimit(memoryLimit)
+    {}
+
+    Value get(Key const & key) {
+        assert(!(key.transformations & ~(Normalize | Canonicalize)));
+        std::shared_future<Value> value;
+        {
+            std::shared_lock<std::shared_timed_mutex> const lock(m_mutex);
+            auto const it(m_entries.find(key));
+            if (it != m_entries.end()) {
+                touch(it->second);
+                value = it->second.value;
+            }
+        }
+        if (value.valid())
+            return value.get();
+
+        /* Not cached, either register to generate the value or wait for the
+           thread which registered first: */
+        std::promise<Value> promise;
+        bool generate;
+        {
+            std::lock_guard<std::shared_timed_mutex> const lock(m_mutex);
+            auto const r(m_entries.emplace(std::piecewise_construct,
+                                           std::forward_as_tuple(key),
+                                           std::forward_as_tuple()));
+            auto & entry = r.first->second;
+            generate = r.second;
+            if (generate)
+                entry.value = promise.get_future().share();
+            touch(entry);
+            value = entry.value;
+        }
+        if (!generate)
+            return value.get();
+
+        Value newValue;
+        try {
+            newValue = create(key);
+        } catch (...) {
+            {
+                std::lock_guard<std::shared_timed_mutex> const lock(m_mutex);
+                m_entries.erase(key);
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+        promise.set_value(newValue);
+
+        auto const memoryUsage = newValue.network
+                                 ? estimateMemoryUsage(*newValue.network)
+                                 : estimateMemoryUsage(
+                                       *newValue.compiledNetwork);
+        std::lock_guard<std::shared_timed_mutex> const lock(m_mutex);
+        auto const it(m_entries.find(key));
+        assert(it != m_entries.end()); // Not evicted before it is ready
+        it->second.ready = true;
+        it->second.memoryUsage = memoryUsage;
+        m_memoryUsage += memoryUsage;
+        evict();
+        return newValue;
+    }
+
+    Value create(Key const & key) {
+        if (key.compiled) {
+            auto const network(get(Key{key.algorithm,
+                                       key.numInputs,
+                                       key.transformations,
+                                       false}).network);
+            return Value{nullptr,
+                         std::make_shared<CompiledNetwork const>(*network)};
+        }
+        auto network(Network::make(key.algorithm, key.numInputs));
+        if (key.transformations & Normalize)
+            network.normalize();
+        if (key.transformations & Canonicalize)
+            network.canonicalize();
+        return Value{std::make_shared<Network const>(std::move(network)),
+                     nullptr};
+    }
+
+    void touch(Entry & entry) noexcept {
+        entry.lastUsed.store(
+                    m_clock.fetch_add(1u, std::memory_order_relaxed) + 1u,
+                    std::memory_order_relaxed);
+    }
+
+    /**
+      Evicts the least recently used ready entries until the memory limit is
+      satisfied. Every eviction scans all entries, which is cheap for the few
+      dozen distinct networks typically in use. Must be called under an
+      exclusive lock.
+    */
+    void evict() noexcept {
+        if (!m_memoryLimit)
+            return;
+        while (m_memoryUsage > m_memoryLimit) {
+            auto lru(m_entries.end());
+            for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+                if (!it->second.ready)
+                    continue;
+                if ((lru == m_entries.end())
+                    || (it->second.lastUsed.load(std::memory_order_relaxed)
+                        < lru->second.lastUsed.load(std::memory_order_relaxed)))
+                    lru = it;
+            }
+            if (lru == m_entries.end())
+                return;
+            m_memoryUsage -= lru->second.memoryUsage;
+            m_entries.erase(lru);
+        }
+    }
+
+/* Fields: */
+
+    mutable std::shared_timed_mutex m_mutex;
+    std::map<Key, Entry> m_entries;
+    std::atomic<std::uint64_t> m_clock{0u};
+    std::size_t m_memoryLimit;
+    std::size_t m_memoryUsage = 0u;
+
+};
+
+NetworkFactory::NetworkFactory(std::size_t memoryLimit)
+    : m_inner(new Inner(memoryLimit))
+{}
+
+NetworkFactory::~NetworkFactory() noexcept = default;
+
+NetworkFactory & NetworkFactory::instance() {
+    static NetworkFactory factory;
+    return factory;
+}
+
+std::shared_ptr<Network const> NetworkFactory::network(
+        Algorithm algorithm,
+        std::size_t numInputs,
+        unsigned transformations)
+{
+    return m_inner->get(
+                Inner::Key{algorithm, numInputs, transformations, false})
+            .network;
+}
+
+std::shared_ptr<CompiledNetwork const> NetworkFactory::compiledNetwork(
+        Algorithm algorithm,
+        std::size_t numInputs,
+        unsigned transformations)
+{
+    return m_inner->get(
+                Inner::Key{algorithm, numInputs, transformations, true})
+            .compiledNetwork;
+}
+
+std::size_t NetworkFactory::memoryLimit() const noexcept {
+    std::shared_lock<std::shared_timed_mutex> const lock(m_inner->m_mutex);
+    return m_inner->m_memoryLimit;
+}
+
+void NetworkFactory::setMemoryLimit(std::size_t memoryLimit) noexcept {
+    std::lock_guard<std::shared_timed_mutex> const lock(m_inner->m_mutex);
+    m_inner->m_memoryLimit = memoryLimit;
+    m_inner->evict();
+}
+
+std::size_t NetworkFactory::memoryUsage() const noexcept {
+    std::shared_lock<std::shared_timed_mutex> const lock(m_inner->m_mutex);
+    return m_inner->m_memoryUsage;
+}
+
+std::size_t NetworkFactory::size() const noexcept {
+    std::shared_lock<std::shared_timed_mutex> const lock(m_inner->m_mutex);
+    return m_inner->m_entries.size();
+}
+
+void NetworkFactory::clear() noexcept {
+    std::lock_guard<std::shared_timed_mutex> const lock(m_inner->m_mutex);
+    auto & entries = m_inner->m_entries;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.ready) {
+            m_inner->m_memoryUsage -= it->second.memoryUsage;
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_NETWORKFACTORY_H
+#define SHAREMIND_LIBSORTNETWORK_NETWORKFACTORY_H
+
+#include <cstddef>
+#include <memory>
+#include "Algorithm.h"
+#include "CompiledNetwork.h"
+#include "Network.h"
+
+
+namespace sharemind {
+namespace SortingNetwork {
+
+/**
+  A thread-safe memoizing factory of sorting networks. The generated networks
+  and their compiled forms are cached and shared as immutable objects, i.e.
+  repeated requests for a network with the same algorithm, number of inputs and
+  transformations return the same instance. Lookups of cached networks only
+  take a shared lock, so they may proceed concurrently. A network requested by
+  several threads at once is generated only once, by the first of them.
+
+  Optionally the estimated amount of memory used by the cached networks can be
+  limited, in which case the least recently used networks are evicted from the
+  cache to satisfy the limit. Evicted networks remain valid for as long as they
+  are referenced elsewhere.
+*/
+class NetworkFactory {
+
+public: /* Types: */
+
+    /** Transformations to apply to generated networks, may be combined: */
+    enum Transformation : unsigned {
+        NoTransformation = 0u,
+
+        /** Network::normalize() is applied. */
+        Normalize = 1u,
+
+        /** Network::canonicalize() is applied (after normalization). */
+        Canonicalize = 2u
+    };
+
+public: /* Methods: */
+
+    /**
+      Creates a new empty factory.
+      \param[in] memoryLimit The limit on the estimated amount of memory used by
+                             the cached networks in bytes, or zero for none.
+    */
+    explicit NetworkFactory(std::size_t memoryLimit = 0u);
+
+    NetworkFactory(NetworkFactory &&) = delete;
+    NetworkFactory(NetworkFactory const &) = delete;
+
+    NetworkFactory & operator=(NetworkFactory &&) = delete;
+    NetworkFactory & operator=(NetworkFactory const &) = delete;
+
+    ~NetworkFactory() noexcept;
+
+    /** \returns the process-wide factory, which has no memory limit unless
+                 one is set using setMemoryLimit(). */
+    static NetworkFactory & instance();
+
+    /**
+      \param[in] algorithm The algorithm of the sorting network.
+      \param[in] numInputs The number of inputs of the sorting network.
+      \param[in] transformations The bitwise OR of the transformations to apply.
+      \returns the shared sorting network.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    std::shared_ptr<Network const> network(
+            Algorithm algorithm,
+            std::size_t numInputs,
+            unsigned transformations = NoTransformation);
+
+    /**
+      \param[in] algorithm The algorithm of the sorting network.
+      \param[in] numInputs The number of inputs of the sorting network.
+      \param[in] transformations The bitwise OR of the transformations to apply.
+      \returns the shared compiled form of the sorting network.
+      \throws std::length_error if the network exceeds the implementation
+                                limits of CompiledNetwork.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    std::shared_ptr<CompiledNetwork const> compiledNetwork(
+            Algorithm algorithm,
+            std::size_t numInputs,
+            unsigned transformations = NoTransformation);
+
+    /** \returns the limit on the estimated amount of memory used by the cached
+                 networks in bytes, or zero if there is no limit. */
+    std::size_t memoryLimit() const noexcept;
+
+    /**
+      Sets the limit on the estimated amount of memory used by the cached
+      networks and evicts the least recently used networks as needed.
+      \param[in] memoryLimit The limit in bytes, or zero for none.
+    */
+    void setMemoryLimit(std::size_t memoryLimit) noexcept;
+
+    /** \returns the estimated amount of memory used by the cached networks. */
+    std::size_t memoryUsage() const noexcept;
+
+    /** \returns the number of cached networks and compiled networks,
+                 including ones being generated. */
+    std::size_t size() const noexcept;
+
+    /** Evicts all cached networks, except ones still being generated. */
+    void clear() noexcept;
+
+private: /* Types: */
+
+    struct Inner;
+
+private: /* Fields: */
+
+    std::unique_ptr<Inner> m_inner;
+
+};
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_NETWORKFACTORY_H */
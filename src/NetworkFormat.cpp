@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#include "NetworkFormat.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace Detail {
+namespace {
+
+constexpr unsigned char const magic[8u] =
+        { 'S', 'O', 'R', 'T', 'N', 'E', 'T', 'W' };
+constexpr std::uint32_t const formatVersion = 1u;
+constexpr std::size_t const checksumOffset = 40u;
+
+/* Bounds which keep all sizes computed from a header from overflowing: */
+constexpr std::uint64_t const maxNumStages = std::uint64_t(1u) << 56u;
+constexpr std::uint64_t const maxNumComparators = std::uint64_t(1u) << 56u;
+
+template <typename T>
+void encodeLittleEndian(T value, unsigned char * out) noexcept {
+    for (std::size_t i = 0u; i < sizeof(T); ++i)
+        out[i] = static_cast<unsigned char>(value >> (i * 8u));
+}
+
+template <typename T>
+T decodeLittleEndian(unsigned char const * in) noexcept {
+    T r = 0u;
+    for (std::size_t i = 0u; i < sizeof(T); ++i)
+        r = static_cast<T>(r | (static_cast<T>(in[i]) << (i * 8u)));
+    return r;
+}
+
+/**
+  Computes the word-wise checksum described in NetworkFormat.h incrementally:
+*/
+class Checksum {
+
+public: /* Methods: */
+
+    void update(unsigned char const * data, std::size_t size) noexcept {
+        while (size) {
+            auto const n = std::min(size, sizeof(m_word) - m_wordSize);
+            std::memcpy(m_word + m_wordSize, data, n);
+            m_wordSize += n;
+            data += n;
+            size -= n;
+            if (m_wordSize == sizeof(m_word)) {
+                addWord();
+                m_wordSize = 0u;
+            }
+        }
+    }
+
+    std::uint64_t value() noexcept {
+        if (m_wordSize) {
+            std::fill(m_word + m_wordSize, m_word + sizeof(m_word), 0u);
+            addWord();
+            m_wordSize = 0u;
+        }
+        return m_hash;
+    }
+
+private: /* Methods: */
+
+    void addWord() noexcept {
+        m_hash ^= decodeLittleEndian<std::uint64_t>(m_word);
+        m_hash *= 0x100000001b3u;
+    }
+
+private: /* Fields: */
+
+    std::uint64_t m_hash = 0xcbf29ce484222325u;
+    unsigned char m_word[8u];
+    std::size_t m_wordSize = 0u;
+
+};
+
+void encodeHeader(NetworkFileHeader const & header,
+                  unsigned char * out) noexcept
+{
+    std::copy(magic, magic + sizeof(magic), out);
+    encodeLittleEndian(formatVersion, out + 8u);
+    encodeLittleEndian(header.indexSize, out + 12u);
+    encodeLittleEndian(header.numInputs, out + 16u);
+    encodeLittleEndian(header.numStages, out + 24u);
+    encodeLittleEndian(header.numComparators, out + 32u);
+    encodeLittleEndian(header.checksum, out + 40u);
+}
+
+/** Starts computing the checksum of a file with the given header: */
+Checksum headerChecksum(NetworkFileHeader const & header) noexcept {
+    unsigned char data[networkFileHeaderSize];
+    encodeHeader(header, data);
+    Checksum checksum;
+    checksum.update(data, checksumOffset);
+    return checksum;
+}
+
+/**
+  Encodes the payload of the given network in chunks, calling sink(data, size)
+  for each chunk.
+*/
+template <typename Sink>
+void encodePayload(Network const & network,
+                   std::uint32_t indexSize,
+                   Sink && sink)
+{
+    constexpr std::size_t const bufferSize = 65536u;
+    unsigned char buffer[bufferSize];
+    std::size_t size = 0u;
+    auto const reserve =
+            [&buffer, &size, &sink](std::size_t n) {
+                if (size + n > bufferSize) {
+                    sink(buffer, size);
+                    size = 0u;
+                }
+            };
+
+    std::uint64_t offset = 0u;
+    reserve(8u);
+    encodeLittleEndian(offset, buffer + size);
+    size += 8u;
+    for (auto const & stage : network.stages()) {
+        offset += stage.numComparators();
+        reserve(8u);
+        encodeLittleEndian(offset, buffer + size);
+        size += 8u;
+    }
+
+    for (auto const & stage : network.stages()) {
+        for (auto const & c : stage.comparators()) {
+            reserve(2u * indexSize);
+            if (indexSize == 2u) {
+                encodeLittleEndian(static_cast<std::uint16_t>(c.min()),
+                                   buffer + size);
+                encodeLittleEndian(static_cast<std::uint16_t>(c.max()),
+                                   buffer + size + 2u);
+            } else {
+                encodeLittleEndian(static_cast<std::uint32_t>(c.min()),
+                                   buffer + size);
+                encodeLittleEndian(static_cast<std::uint32_t>(c.max()),
+                                   buffer + size + 4u);
+            }
+            size += 2u * indexSize;
+        }
+    }
+    if (size)
+        sink(buffer, size);
+}
+
+template <typename Index>
+void validateComparators(NetworkFileHeader const & header,
+                         unsigned char const * data)
+{
+    for (std::uint64_t i = 0u; i < header.numComparators; ++i) {
+        auto const min = decodeLittleEndian<Index>(data);
+        auto const max = decodeLittleEndian<Index>(data + sizeof(Index));
+        if ((min >= header.numInputs)
+            || (max >= header.numInputs)
+            || (min == max))
+            throw InvalidNetworkFormat("Invalid comparator in network data!");
+        data += 2u * sizeof(Index);
+    }
+}
+
+template <typename Index>
+Network decodeNetwork(NetworkFileHeader const & header,
+                      unsigned char const * payload)
+{
+    auto const numInputs = static_cast<std::size_t>(header.numInputs);
+    auto const numStages = static_cast<std::size_t>(header.numStages);
+    auto comparatorData = payload + (numStages + 1u) * 8u;
+
+    Network::Stages stages;
+    stages.reserve(numStages);
+    // The 1-based index of the last stage which used each line:
+    std::vector<std::size_t> lineStages(numInputs, 0u);
+    for (std::size_t s = 0u; s < numStages; ++s) {
+        auto const begin = decodeLittleEndian<std::uint64_t>(payload + s * 8u);
+        auto const end =
+                decodeLittleEndian<std::uint64_t>(payload + (s + 1u) * 8u);
+        Stage::Comparators comparators;
+        comparators.reserve(static_cast<std::size_t>(end - begin));
+        for (auto i = begin; i < end; ++i) {
+            std::size_t const min = decodeLittleEndian<Index>(comparatorData);
+            std::size_t const max =
+                    decodeLittleEndian<Index>(comparatorData + sizeof(Index));
+            comparatorData += 2u * sizeof(Index);
+            if ((lineStages[min] == s + 1u) || (lineStages[max] == s + 1u))
+                throw InvalidNetworkFormat(
+                        "Conflicting comparators in network stage!");
+            lineStages[min] = s + 1u;
+            lineStages[max] = s + 1u;
+            comparators.emplace_back(min, max);
+        }
+        stages.emplace_back(std::move(comparators));
+    }
+
+    Network network(numInputs);
+    network.composeWithStages(std::move(stages));
+    return network;
+}
+
+} // anonymous namespace
+
+bool hostIsLittleEndian() noexcept {
+    std::uint16_t const value = 1u;
+    unsigned char bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    return bytes[0u] == 1u;
+}
+
+NetworkFileHeader decodeNetworkFileHeader(unsigned char const * data) {
+    if (!std::equal(magic, magic + sizeof(magic), data))
+        throw InvalidNetworkFormat("Not a comparator network file!");
+    if (decodeLittleEndian<std::uint32_t>(data + 8u) != formatVersion)
+        throw InvalidNetworkFormat("Unsupported network format version!");
+    NetworkFileHeader header;
+    header.indexSize = decodeLittleEndian<std::uint32_t>(data + 12u);
+    header.numInputs = decodeLittleEndian<std::uint64_t>(data + 16u);
+    header.numStages = decodeLittleEndian<std::uint64_t>(data + 24u);
+    header.numComparators = decodeLittleEndian<std::uint64_t>(data + 32u);
+    header.checksum = decodeLittleEndian<std::uint64_t>(data + 40u);
+    if ((header.indexSize != 2u) && (header.indexSize != 4u))
+        throw InvalidNetworkFormat("Invalid index size in network header!");
+    if ((header.numInputs > (std::uint64_t(1u) << (header.indexSize * 8u)))
+        || (header.numStages >= maxNumStages)
+        || (header.numComparators >= maxNumComparators))
+        throw InvalidNetworkFormat("Invalid sizes in network header!");
+    if ((header.numInputs > std::numeric_limits<std::size_t>::max())
+        || (networkFilePayloadSize(header)
+            > std::numeric_limits<std::size_t>::max()))
+        throw InvalidNetworkFormat("Network too large for this host!");
+    return header;
+}
+
+std::uint64_t networkFilePayloadSize(NetworkFileHeader const & header) noexcept
+{
+    return (header.numStages + 1u) * 8u
+           + header.numComparators * 2u * header.indexSize;
+}
+
+void validateNetworkFilePayload(NetworkFileHeader const & header,
+                                unsigned char const * payload,
+                                bool verifyChecksum)
+{
+    if (verifyChecksum) {
+        auto checksum(headerChecksum(header));
+        checksum.update(payload,
+                        static_cast<std::size_t>(
+                            networkFilePayloadSize(header)));
+        if (checksum.value() != header.checksum)
+            throw InvalidNetworkFormat("Network data checksum mismatch!");
+    }
+
+    std::uint64_t previousOffset = 0u;
+    for (std::uint64_t i = 0u; i <= header.numStages; ++i) {
+        auto const offset =
+                decodeLittleEndian<std::uint64_t>(payload + i * 8u);
+        if ((i == 0u) ? (offset != 0u) : (offset < previousOffset))
+            throw InvalidNetworkFormat("Invalid stage offsets in network!");
+        previousOffset = offset;
+    }
+    if (previousOffset != header.numComparators)
+        throw InvalidNetworkFormat("Invalid stage offsets in network!");
+
+    auto const comparators = payload + (header.numStages + 1u) * 8u;
+    if (header.indexSize == 2u) {
+        validateComparators<std::uint16_t>(header, comparators);
+    } else {
+        validateComparators<std::uint32_t>(header, comparators);
+    }
+}
+
+Network decodeNetworkFilePayload(NetworkFileHeader const & header,
+                                 unsigned char const * payload)
+{
+    return (header.indexSize == 2u)
+           ? decodeNetwork<std::uint16_t>(header, payload)
+           : decodeNetwork<std::uint32_t>(header, payload);
+}
+
+} /* namespace Detail { */
+
+void Network::save(std::ostream & out) const {
+    if (m_numInputs > (std::uint64_t(1u) << 32u))
+        throw std::length_error("Network too large to save!");
+    Detail::NetworkFileHeader header;
+    header.indexSize = (m_numInputs <= 65536u) ? 2u : 4u;
+    header.numInputs = m_numInputs;
+    header.numStages = m_stages.size();
+    header.numComparators = numComparators();
+    header.checksum = 0u;
+
+    auto checksum(Detail::headerChecksum(header));
+    Detail::encodePayload(
+                *this,
+                header.indexSize,
+                [&checksum](unsigned char const * data, std::size_t size)
+                { checksum.update(data, size); });
+    header.checksum = checksum.value();
+
+    unsigned char headerData[Detail::networkFileHeaderSize];
+    Detail::encodeHeader(header, headerData);
+    out.write(reinterpret_cast<char const *>(headerData), sizeof(headerData));
+    Detail::encodePayload(
+                *this,
+                header.indexSize,
+                [&out](unsigned char const * data, std::size_t size) {
+                    out.write(reinterpret_cast<char const *>(data),
+                              static_cast<std::streamsize>(size));
+                });
+}
+
+Network Network::load(std::istream & in) {
+    unsigned char headerData[Detail::networkFileHeaderSize];
+    if (!in.read(reinterpret_cast<char *>(headerData), sizeof(headerData)))
+        throw InvalidNetworkFormat("Truncated network data!");
+    auto const header(Detail::decodeNetworkFileHeader(headerData));
+
+    /* Read the payload in chunks so corrupt sizes in the header can not cause
+       huge allocations up front. The payload is stored as 64-bit words to keep
+       it aligned like a memory-mapped file. */
+    auto const payloadSize =
+            static_cast<std::size_t>(Detail::networkFilePayloadSize(header));
+    constexpr std::size_t const chunkSize = std::size_t(1u) << 20u;
+    std::vector<std::uint64_t> payload;
+    for (std::size_t size = 0u; size < payloadSize;) {
+        auto const n = std::min(chunkSize, payloadSize - size);
+        payload.resize((size + n + 7u) / 8u);
+        if (!in.read(reinterpret_cast<char *>(payload.data()) + size,
+                     static_cast<std::streamsize>(n)))
+            throw InvalidNetworkFormat("Truncated network data!");
+        size += n;
+    }
+
+    auto const payloadData =
+            reinterpret_cast<unsigned char const *>(payload.data());
+    Detail::validateNetworkFilePayload(header, payloadData, true);
+    return Detail::decodeNetworkFilePayload(header, payloadData);
+}
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_NETWORKFORMAT_H
+#define SHAREMIND_LIBSORTNETWORK_NETWORKFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include "Network.h"
+
+
+/*
+  The binary format of comparator networks (see Network::save()) consists of a
+  header of 48 bytes followed by the payload. All integers are stored in little
+  endian byte order. The header consists of
+
+    offset  size  contents
+         0     8  the magic bytes "SORTNETW"
+         8     4  the format version, currently 1
+        12     4  the size of line indexes in bytes, i.e. 2 or 4
+        16     8  the number of inputs
+        24     8  the number of stages
+        32     8  the number of comparators
+        40     8  the checksum described below
+
+  and the payload consists of the table of the numStages + 1 stage offsets of
+  8 bytes each, where the comparators of the i-th stage are the ones with
+  indexes in the range [offset[i], offset[i + 1]), followed by the packed pairs
+  of the minimum and maximum line indexes of all comparators. Both parts of the
+  payload are aligned to their element sizes when the file is mapped at a page
+  boundary. The checksum is computed over the first 40 bytes of the header
+  followed by the payload, split into 64-bit little endian words where the last
+  word is padded with zero bytes. Starting from h = 0xcbf29ce484222325, every
+  word w updates h to (h XOR w) * 0x100000001b3 modulo 2^64. Note that unlike
+  FNV-1a, which uses the same constants, this processes whole words instead of
+  single bytes, hence the checksum differs from the FNV-1a hash of the data.
+*/
+
+namespace sharemind {
+namespace SortingNetwork {
+
+/** Thrown when loading a comparator network of invalid binary format. */
+class InvalidNetworkFormat: public std::runtime_error {
+
+public: /* Methods: */
+
+    using std::runtime_error::runtime_error;
+
+};
+
+namespace Detail {
+
+constexpr std::size_t const networkFileHeaderSize = 48u;
+
+struct NetworkFileHeader {
+    std::uint32_t indexSize;
+    std::uint64_t numInputs;
+    std::uint64_t numStages;
+    std::uint64_t numComparators;
+    std::uint64_t checksum;
+};
+
+/** \returns whether the host stores integers in little endian byte order. */
+bool hostIsLittleEndian() noexcept;
+
+/**
+  Decodes and validates a header.
+  \param[in] data Pointer to the networkFileHeaderSize bytes of the header.
+  \throws InvalidNetworkFormat if the header is invalid.
+*/
+NetworkFileHeader decodeNetworkFileHeader(unsigned char const * data);
+
+/** \returns the size of the payload in bytes for a valid header. */
+std::uint64_t networkFilePayloadSize(NetworkFileHeader const & header) noexcept;
+
+/**
+  Validates a payload.
+  \param[in] header The valid header.
+  \param[in] payload Pointer to networkFilePayloadSize(header) bytes of the
+                     payload, aligned to 8 bytes.
+  \param[in] verifyChecksum Whether to verify the checksum.
+  \throws InvalidNetworkFormat if the payload is invalid.
+*/
+void validateNetworkFilePayload(NetworkFileHeader const & header,
+                                unsigned char const * payload,
+                                bool verifyChecksum);
+
+/**
+  Decodes a payload validated by validateNetworkFilePayload().
+  \throws InvalidNetworkFormat if a stage uses a line more than once.
+  \throws std::bad_alloc an out-of-memory condition was encountered.
+*/
+Network decodeNetworkFilePayload(NetworkFileHeader const & header,
+                                 unsigned char const * payload);
+
+} /* namespace Detail { */
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_NETWORKFORMAT_H */
@@ -0,0 +1,916 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#include "Network.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define SHAREMIND_LIBSORTNETWORK_X86_VERIFIER 1
+#endif
+
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace {
+
+/*
+  The 0-1 patterns are evaluated in blocks of blockSize patterns at once. Every
+  line holds a bit-plane of blockWords 64-bit words, where bit j of word w is
+  the value of the line in pattern number (block * blockSize + w * 64 + j).
+  Hence a comparator is evaluated for the whole block as an AND for its minimum
+  line and an OR for its maximum line. With GCC and Clang a bit-plane is a
+  vector type, so these compile to SIMD instructions (AVX2 where available).
+*/
+constexpr std::size_t const blockWordsLog2 = 3u;
+constexpr std::size_t const blockWords = std::size_t(1u) << blockWordsLog2;
+constexpr std::size_t const blockSizeLog2 = 6u + blockWordsLog2;
+
+/* The bit-planes are aligned to their size, since code using wider
+   instructions may assume a larger alignment than alignof(Block): */
+constexpr std::size_t const blockAlignment = blockWords * 8u;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SHAREMIND_LIBSORTNETWORK_ALWAYS_INLINE __attribute__((always_inline))
+typedef std::uint64_t Block __attribute__((vector_size(blockAlignment)));
+#else
+#define SHAREMIND_LIBSORTNETWORK_ALWAYS_INLINE
+struct Block {
+    Block operator&(Block const & rhs) const noexcept {
+        Block r;
+        for (std::size_t w = 0u; w < blockWords; ++w)
+            r.words[w] = words[w] & rhs.words[w];
+        return r;
+    }
+
+    Block operator|(Block const & rhs) const noexcept {
+        Block r;
+        for (std::size_t w = 0u; w < blockWords; ++w)
+            r.words[w] = words[w] | rhs.words[w];
+        return r;
+    }
+
+    std::uint64_t words[blockWords];
+};
+#endif
+
+/** The bit-planes of the lines numbered below 6 within any 64-bit word: */
+constexpr std::uint64_t const lowLineMasks[6u] = {
+    0xaaaaaaaaaaaaaaaau,
+    0xccccccccccccccccu,
+    0xf0f0f0f0f0f0f0f0u,
+    0xff00ff00ff00ff00u,
+    0xffff0000ffff0000u,
+    0xffffffff00000000u
+};
+
+/** The minimum number of blocks to justify using another thread: */
+constexpr std::uint64_t const minBlocksPerThread = 1024u;
+
+/** All 2^n 0-1 patterns, where pattern number p holds bit i of p on line i: */
+class AllPatterns {
+
+public: /* Methods: */
+
+    explicit AllPatterns(std::size_t numInputs) noexcept
+        : m_numInputs(numInputs)
+    {}
+
+    std::uint64_t numBlocks() const noexcept {
+        return (m_numInputs > blockSizeLog2)
+               ? (std::uint64_t(1u) << (m_numInputs - blockSizeLog2))
+               : 1u;
+    }
+
+    SHAREMIND_LIBSORTNETWORK_ALWAYS_INLINE
+    void fill(std::uint64_t block, std::uint64_t * planes) const noexcept {
+        for (std::size_t line = 0u; line < m_numInputs; ++line) {
+            auto const plane = planes + line * blockWords;
+            for (std::size_t w = 0u; w < blockWords; ++w) {
+                if (line < 6u) {
+                    plane[w] = lowLineMasks[line];
+                } else if (line < blockSizeLog2) {
+                    plane[w] = ((w >> (line - 6u)) & 1u)
+                               ? ~std::uint64_t(0u)
+                               : std::uint64_t(0u);
+                } else {
+                    plane[w] = ((block >> (line - blockSizeLog2)) & 1u)
+                               ? ~std::uint64_t(0u)
+                               : std::uint64_t(0u);
+                }
+            }
+        }
+    }
+
+private: /* Fields: */
+
+    std::size_t const m_numInputs;
+
+};
+
+/**
+  The (n0 + 1) * (n1 + 1) 0-1 patterns consisting of a sorted sequence of n0
+  values followed by a sorted sequence of n1 values. Pattern number p has the
+  p / (n1 + 1) topmost of the first n0 lines and the p % (n1 + 1) topmost of
+  the last n1 lines set. Patterns past the last one in the last block are
+  all-zero, hence trivially sorted.
+*/
+class MergePatterns {
+
+public: /* Methods: */
+
+    MergePatterns(std::size_t n0, std::size_t n1) noexcept
+        : m_n0(n0)
+        , m_n1(n1)
+    {}
+
+    std::uint64_t numBlocks() const noexcept {
+        auto const numPatterns = (std::uint64_t(m_n0) + 1u)
+                                 * (std::uint64_t(m_n1) + 1u);
+        return (numPatterns + (std::uint64_t(1u) << blockSizeLog2) - 1u)
+               >> blockSizeLog2;
+    }
+
+    /**
+      Sets the bit of each pattern on the first line holding 1 in each half,
+      then propagates these bits upwards to the last line of the half.
+    */
+    SHAREMIND_LIBSORTNETWORK_ALWAYS_INLINE
+    void fill(std::uint64_t block, std::uint64_t * planes) const noexcept {
+        auto const n = m_n0 + m_n1;
+        for (std::size_t i = 0u; i < n * blockWords; ++i)
+            planes[i] = 0u;
+        auto const rowSize = std::uint64_t(m_n1) + 1u;
+        auto const numPatterns = (std::uint64_t(m_n0) + 1u) * rowSize;
+        auto const first = block << blockSizeLog2;
+        auto const end = std::min(first + (std::uint64_t(1u) << blockSizeLog2),
+                                  numPatterns);
+        auto ones0 = static_cast<std::size_t>(first / rowSize);
+        auto ones1 = static_cast<std::size_t>(first % rowSize);
+        for (auto p = first; p < end; ++p) {
+            auto const offset = static_cast<std::size_t>(p - first);
+            auto const w = offset >> 6u;
+            auto const bit = std::uint64_t(1u) << (offset & 63u);
+            if (ones0)
+                planes[(m_n0 - ones0) * blockWords + w] |= bit;
+            if (ones1)
+                planes[(n - ones1) * blockWords + w] |= bit;
+            if (++ones1 == rowSize) {
+                ones1 = 0u;
+                ++ones0;
+            }
+        }
+        for (std::size_t line = 1u; line < n; ++line) {
+            if (line == m_n0)
+                continue;
+            auto const prevPlane = planes + (line - 1u) * blockWords;
+            auto const plane = planes + line * blockWords;
+            for (std::size_t w = 0u; w < blockWords; ++w)
+                plane[w] |= prevPlane[w];
+        }
+    }
+
+private: /* Fields: */
+
+    std::size_t const m_n0;
+    std::size_t const m_n1;
+
+};
+
+template <typename Patterns>
+class BitParallelVerifier {
+
+public: /* Methods: */
+
+    BitParallelVerifier(Network const & network, Patterns patterns)
+        : m_numInputs(network.numInputs())
+        , m_patterns(std::move(patterns))
+    {
+        m_comparators.reserve(network.numComparators() * 2u);
+        for (auto const & stage : network.stages()) {
+            for (auto const & c : stage.comparators()) {
+                m_comparators.emplace_back(c.min());
+                m_comparators.emplace_back(c.max());
+            }
+        }
+    }
+
+    std::size_t numInputs() const noexcept { return m_numInputs; }
+
+    std::uint64_t numBlocks() const noexcept { return m_patterns.numBlocks(); }
+
+    /**
+      Checks whether all 0-1 patterns in the blocks [begin, end) are sorted.
+      \param[in] planes Scratch space of numInputs() * blockWords words.
+      \param[in] failed Set to true on failure, stops other threads early.
+    */
+    void verifyBlocks(std::uint64_t begin,
+                      std::uint64_t end,
+                      std::uint64_t * planes,
+                      std::atomic<bool> & failed) const noexcept
+    {
+        #ifdef SHAREMIND_LIBSORTNETWORK_X86_VERIFIER
+        if (__builtin_cpu_supports("avx2"))
+            return verifyBlocksAvx2(begin, end, planes, failed);
+        #endif
+        verifyBlocks_(begin, end, planes, failed);
+    }
+
+    /**
+      Verifies all blocks of patterns, split between threads.
+      \param[in] numThreads The maximum number of threads, or zero to use the
+                            number of hardware threads.
+    */
+    bool verify(std::size_t numThreads) const {
+        auto const numBlocks = m_patterns.numBlocks();
+        if (!numThreads)
+            numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        numThreads = static_cast<std::size_t>(
+                         std::max(std::min<std::uint64_t>(
+                                      numThreads,
+                                      numBlocks / minBlocksPerThread),
+                                  std::uint64_t(1u)));
+
+        // Allocate everything up front, so the threads never fail:
+        auto const planesSize = numThreads * m_numInputs * blockWords;
+        std::vector<std::uint64_t> planesData(planesSize + blockWords);
+        void * planesBase = planesData.data();
+        std::size_t planesSpace = planesData.size() * sizeof(std::uint64_t);
+        auto const planes =
+                static_cast<std::uint64_t *>(
+                    std::align(blockAlignment,
+                               planesSize * sizeof(std::uint64_t),
+                               planesBase,
+                               planesSpace));
+        std::atomic<bool> failed(false);
+        auto const blocksPerThread = numBlocks / numThreads;
+        auto const runThread =
+                [this, planes, &failed, numBlocks, blocksPerThread, numThreads]
+                (std::size_t i) noexcept
+                {
+                    verifyBlocks(i * blocksPerThread,
+                                 (i + 1u == numThreads)
+                                 ? numBlocks
+                                 : (i + 1u) * blocksPerThread,
+                                 planes + i * m_numInputs * blockWords,
+                                 failed);
+                };
+
+        std::vector<std::thread> threads;
+        threads.reserve(numThreads - 1u);
+        try {
+            for (std::size_t i = 1u; i < numThreads; ++i)
+                threads.emplace_back(runThread, i);
+        } catch (...) {
+            failed.store(true, std::memory_order_relaxed);
+            for (auto & thread : threads)
+                thread.join();
+            throw;
+        }
+        runThread(0u);
+        for (auto & thread : threads)
+            thread.join();
+        return !failed.load(std::memory_order_relaxed);
+    }
+
+private: /* Methods: */
+
+    #ifdef SHAREMIND_LIBSORTNETWORK_X86_VERIFIER
+    __attribute__((target("avx2")))
+    void verifyBlocksAvx2(std::uint64_t begin,
+                          std::uint64_t end,
+                          std::uint64_t * planes,
+                          std::atomic<bool> & failed) const noexcept
+    { verifyBlocks_(begin, end, planes, failed); }
+    #endif
+
+    /* Always inlined, so that the above is vectorized using AVX2: */
+    SHAREMIND_LIBSORTNETWORK_ALWAYS_INLINE
+    void verifyBlocks_(std::uint64_t begin,
+                       std::uint64_t end,
+                       std::uint64_t * planes,
+                       std::atomic<bool> & failed) const noexcept
+    {
+        auto const numInputs = m_numInputs;
+        for (auto block = begin; block < end; ++block) {
+            if (failed.load(std::memory_order_relaxed))
+                return;
+
+            m_patterns.fill(block, planes);
+
+            auto const comparatorsEnd = m_comparators.data()
+                                        + m_comparators.size();
+            for (auto it = m_comparators.data(); it != comparatorsEnd; it += 2)
+            {
+                auto const minPlane = reinterpret_cast<Block *>(
+                                          planes + it[0u] * blockWords);
+                auto const maxPlane = reinterpret_cast<Block *>(
+                                          planes + it[1u] * blockWords);
+                auto const a = *minPlane;
+                auto const b = *maxPlane;
+                *minPlane = a & b;
+                *maxPlane = a | b;
+            }
+
+            // A pattern is unsorted iff some line holds 1 and the next one 0:
+            std::uint64_t unsorted = 0u;
+            for (std::size_t line = 1u; line < numInputs; ++line) {
+                auto const prevPlane = planes + (line - 1u) * blockWords;
+                auto const plane = planes + line * blockWords;
+                for (std::size_t w = 0u; w < blockWords; ++w)
+                    unsorted |= prevPlane[w] & ~plane[w];
+            }
+            if (unsorted) {
+                failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+private: /* Fields: */
+
+    std::size_t const m_numInputs;
+    Patterns const m_patterns;
+
+    /** The minimum and maximum lines of all comparators, interleaved: */
+    std::vector<std::size_t> m_comparators;
+
+};
+
+/**
+  Verifies sorting networks by propagating the sets of reachable 0-1 vectors
+  stage by stage, where each 0-1 vector is stored as a 64-bit mask of lines.
+  Lines are grouped into components of lines connected by the comparators seen
+  so far. Since components are independent, each holds the set of reachable
+  0-1 vectors on its lines only, and the sets of two components are combined
+  into their product only when a comparator connects them. Lines not yet
+  touched by any comparator are not stored at all.
+
+  If the network is equal to its reflection, i.e. mapping every comparator
+  (i, j) to (n - 1 - j, n - 1 - i) yields the same stages, the set of reachable
+  vectors on any set of lines closed under reflection is closed under mapping
+  every vector to its complement in reverse order. Only one vector of every
+  such pair is then stored.
+
+  If the product of sets would exceed the limit on the size of a set, the
+  largest factor is split into parts which are verified separately.
+*/
+class PrefixSetVerifier {
+
+public: /* Constants: */
+
+    constexpr static std::size_t const defaultMaxSetSize =
+            std::size_t(1u) << 24u;
+
+public: /* Methods: */
+
+    PrefixSetVerifier(Network const & network, std::size_t maxSetSize)
+        : m_network(network)
+        , m_numInputs(network.numInputs())
+        , m_allLines((m_numInputs < 64u)
+                     ? ((std::uint64_t(1u) << m_numInputs) - 1u)
+                     : ~std::uint64_t(0u))
+        , m_maxSetSize(maxSetSize ? maxSetSize : defaultMaxSetSize)
+    {}
+
+    bool verify() {
+        if (m_numInputs <= 1u)
+            return true;
+        return verifyFrom(0u, Components(), isSymmetric());
+    }
+
+    /**
+      Finds the comparators which swap their values for some 0-1 vector, hence
+      for some input. Since the sets are neither reduced nor split, this fails
+      if any set would have more than the maximum number of vectors.
+      \param[out] swapping Whether each comparator, in the order of execution,
+                           swaps for some input.
+      \returns whether the sets of vectors stayed within the limit.
+    */
+    bool findSwappingComparators(std::vector<bool> & swapping) {
+        swapping.assign(m_network.numComparators(), false);
+        m_swapping = &swapping;
+        m_stageOffsets.clear();
+        std::size_t offset = 0u;
+        for (auto const & stage : m_network.stages()) {
+            m_stageOffsets.emplace_back(offset);
+            offset += stage.numComparators();
+        }
+        if (m_numInputs > 1u)
+            verifyFrom(0u, Components(), false);
+        m_swapping = nullptr;
+        return !m_exceeded;
+    }
+
+private: /* Types: */
+
+    using Vectors = std::vector<std::uint64_t>;
+
+    struct Component {
+        std::uint64_t lines;
+        Vectors vectors;
+
+        /** Whether only one vector of every reflected pair is stored: */
+        bool reduced;
+    };
+
+    using Components = std::vector<Component>;
+
+    constexpr static std::size_t const noComponent = ~std::size_t(0u);
+
+private: /* Methods: */
+
+    static std::uint64_t swapBits(std::uint64_t v,
+                                  std::uint64_t mask,
+                                  unsigned shift) noexcept
+    { return ((v >> shift) & mask) | ((v & mask) << shift); }
+
+    static std::uint64_t reverseBits(std::uint64_t v) noexcept {
+        v = swapBits(v, 0x5555555555555555u, 1u);
+        v = swapBits(v, 0x3333333333333333u, 2u);
+        v = swapBits(v, 0x0f0f0f0f0f0f0f0fu, 4u);
+        v = swapBits(v, 0x00ff00ff00ff00ffu, 8u);
+        v = swapBits(v, 0x0000ffff0000ffffu, 16u);
+        return (v >> 32u) | (v << 32u);
+    }
+
+    std::uint64_t reflectLines(std::uint64_t lines) const noexcept
+    { return reverseBits(lines) >> (64u - m_numInputs); }
+
+    /** \returns the complement of v on the given lines in reverse order. */
+    std::uint64_t reflect(std::uint64_t v, std::uint64_t lines) const noexcept
+    { return reflectLines(~v & lines); }
+
+    bool isSymmetric() const {
+        /* Comparator::operator== and operator< ignore the direction of the
+           comparators, so the (min, max) pairs are compared instead: */
+        using Pair = std::pair<std::size_t, std::size_t>;
+        auto const n = m_numInputs;
+        std::vector<Pair> comparators;
+        std::vector<Pair> reflected;
+        for (auto const & stage : m_network.stages()) {
+            comparators.clear();
+            reflected.clear();
+            for (auto const & c : stage.comparators()) {
+                comparators.emplace_back(c.min(), c.max());
+                reflected.emplace_back(n - 1u - c.max(), n - 1u - c.min());
+            }
+            std::sort(comparators.begin(), comparators.end());
+            std::sort(reflected.begin(), reflected.end());
+            if (reflected != comparators)
+                return false;
+        }
+        return true;
+    }
+
+    bool isSorted(std::uint64_t v) const noexcept {
+        // The lines holding 1 must be the topmost ones, if any:
+        return !v || (((v + (v & (~v + 1u))) & m_allLines) == 0u);
+    }
+
+    static void deduplicate(Vectors & vectors) {
+        std::sort(vectors.begin(), vectors.end());
+        vectors.erase(std::unique(vectors.begin(), vectors.end()),
+                      vectors.end());
+    }
+
+    void expand(Component & component) const {
+        if (!component.reduced)
+            return;
+        auto & vectors = component.vectors;
+        auto const size = vectors.size();
+        vectors.reserve(size * 2u);
+        for (std::size_t i = 0u; i < size; ++i)
+            vectors.emplace_back(reflect(vectors[i], component.lines));
+        deduplicate(vectors);
+        component.reduced = false;
+    }
+
+    /** \returns a * b, or m_maxSetSize + 1 if that is larger. */
+    std::size_t boundedProduct(std::size_t a, std::size_t b) const noexcept {
+        return (b && (a > m_maxSetSize / b)) ? (m_maxSetSize + 1u) : (a * b);
+    }
+
+    static std::size_t findRoot(std::vector<std::size_t> & parents,
+                                std::size_t i) noexcept
+    {
+        while (parents[i] != i)
+            i = parents[i] = parents[parents[i]];
+        return i;
+    }
+
+    bool verifyFrom(std::size_t stageIndex,
+                    Components components,
+                    bool useSymmetry)
+    {
+        auto const & stages = m_network.stages();
+        std::vector<std::size_t> lineComponents(m_numInputs);
+        std::vector<std::size_t> parents;
+        std::vector<std::vector<std::size_t> > groups;
+        for (; stageIndex < stages.size(); ++stageIndex) {
+            auto const & comparators = stages[stageIndex].comparators();
+            if (comparators.empty())
+                continue;
+
+            // Find the components to merge, creating ones for new lines:
+            std::fill(lineComponents.begin(), lineComponents.end(),
+                      noComponent);
+            for (std::size_t i = 0u; i < components.size(); ++i)
+                for (std::size_t line = 0u; line < m_numInputs; ++line)
+                    if ((components[i].lines >> line) & 1u)
+                        lineComponents[line] = i;
+            for (auto const & c : comparators) {
+                for (auto const line : {c.min(), c.max()}) {
+                    if (lineComponents[line] == noComponent) {
+                        auto const bit = std::uint64_t(1u) << line;
+                        lineComponents[line] = components.size();
+                        components.push_back(Component{bit, {0u, bit}, false});
+                    }
+                }
+            }
+            parents.resize(components.size());
+            for (std::size_t i = 0u; i < parents.size(); ++i)
+                parents[i] = i;
+            for (auto const & c : comparators)
+                parents[findRoot(parents, lineComponents[c.min()])] =
+                        findRoot(parents, lineComponents[c.max()]);
+            groups.assign(components.size(), {});
+            for (std::size_t i = 0u; i < components.size(); ++i)
+                groups[findRoot(parents, i)].emplace_back(i);
+
+            // Prepare the products, splitting if these would be too large:
+            for (auto const & group : groups) {
+                if (group.size() <= 1u)
+                    continue;
+                std::uint64_t lines = 0u;
+                for (auto const i : group)
+                    lines |= components[i].lines;
+                /* If the merged component is closed under reflection, one
+                   reduced factor suffices, see the class description: */
+                std::size_t keptReduced = noComponent;
+                if (useSymmetry && (reflectLines(lines) == lines))
+                    for (auto const i : group)
+                        if (components[i].reduced
+                            && ((keptReduced == noComponent)
+                                || (components[i].vectors.size()
+                                    > components[keptReduced].vectors.size())))
+                            keptReduced = i;
+                std::size_t productSize = 1u;
+                std::size_t largest = group.front();
+                for (auto const i : group) {
+                    if (i != keptReduced)
+                        expand(components[i]);
+                    auto const size = components[i].vectors.size();
+                    productSize = boundedProduct(productSize, size);
+                    if (size > components[largest].vectors.size())
+                        largest = i;
+                }
+                if (productSize <= m_maxSetSize)
+                    continue;
+
+                if (m_swapping) {
+                    m_exceeded = true;
+                    return false;
+                }
+
+                /* The parts of a set are not closed under reflection, hence
+                   the parts are verified without using symmetry: */
+                if (useSymmetry) {
+                    for (auto & component : components)
+                        expand(component);
+                    return verifyFrom(stageIndex, std::move(components), false);
+                }
+                auto const largestSize = components[largest].vectors.size();
+                std::size_t othersSize = 1u;
+                for (auto const i : group)
+                    if (i != largest)
+                        othersSize = boundedProduct(
+                                othersSize,
+                                components[i].vectors.size());
+                auto const partSize = std::max(m_maxSetSize / othersSize,
+                                               std::size_t(1u));
+                Vectors const vectors(std::move(components[largest].vectors));
+                for (std::size_t begin = 0u; begin < largestSize;
+                     begin += partSize)
+                {
+                    auto const end = std::min(begin + partSize, largestSize);
+                    auto part(components);
+                    using D = Vectors::difference_type;
+                    part[largest].vectors.assign(
+                            vectors.begin() + static_cast<D>(begin),
+                            vectors.begin() + static_cast<D>(end));
+                    if (!verifyFrom(stageIndex, std::move(part), false))
+                        return false;
+                }
+                return true;
+            }
+
+            // Merge the components:
+            Components merged;
+            for (auto const & group : groups) {
+                if (group.empty())
+                    continue;
+                if (group.size() == 1u) {
+                    merged.emplace_back(std::move(components[group.front()]));
+                    continue;
+                }
+                Component component{0u, {0u}, false};
+                for (auto const i : group) {
+                    auto & factor = components[i];
+                    Vectors product;
+                    product.reserve(component.vectors.size()
+                                    * factor.vectors.size());
+                    for (auto const a : component.vectors)
+                        for (auto const b : factor.vectors)
+                            product.emplace_back(a | b);
+                    component.lines |= factor.lines;
+                    component.vectors = std::move(product);
+                    component.reduced = component.reduced || factor.reduced;
+                    Vectors().swap(factor.vectors);
+                }
+                merged.emplace_back(std::move(component));
+            }
+            components = std::move(merged);
+
+            // Apply the comparators of the stage:
+            std::vector<std::uint64_t> swaps;
+            std::vector<std::size_t> swapIndexes;
+            std::vector<bool> swapped;
+            for (auto & component : components) {
+                swaps.clear();
+                swapIndexes.clear();
+                for (std::size_t j = 0u; j < comparators.size(); ++j) {
+                    auto const & c = comparators[j];
+                    if ((component.lines >> c.min()) & 1u) {
+                        swaps.emplace_back(std::uint64_t(1u) << c.min());
+                        swaps.emplace_back(std::uint64_t(1u) << c.max());
+                        swapIndexes.emplace_back(j);
+                    }
+                }
+                if (swaps.empty())
+                    continue;
+                swapped.assign(swapIndexes.size(), false);
+                for (auto & v : component.vectors) {
+                    for (std::size_t i = 0u; i < swaps.size(); i += 2u) {
+                        // Swap if the minimum line holds 1 and the maximum 0:
+                        auto const bits = swaps[i] | swaps[i + 1u];
+                        if ((v & bits) == swaps[i]) {
+                            v ^= bits;
+                            swapped[i / 2u] = true;
+                        }
+                    }
+                }
+                if (m_swapping)
+                    for (std::size_t i = 0u; i < swapIndexes.size(); ++i)
+                        if (swapped[i])
+                            (*m_swapping)[m_stageOffsets[stageIndex]
+                                          + swapIndexes[i]] = true;
+                if (useSymmetry
+                    && (reflectLines(component.lines) == component.lines))
+                {
+                    for (auto & v : component.vectors)
+                        v = std::min(v, reflect(v, component.lines));
+                    component.reduced = true;
+                }
+                deduplicate(component.vectors);
+            }
+        }
+
+        // Every line must be connected to every other line:
+        if ((components.size() != 1u)
+            || (components.front().lines != m_allLines))
+            return false;
+        for (auto const v : components.front().vectors)
+            if (!isSorted(v))
+                return false;
+        return true;
+    }
+
+private: /* Fields: */
+
+    Network const & m_network;
+    std::size_t const m_numInputs;
+    std::uint64_t const m_allLines;
+    std::size_t const m_maxSetSize;
+
+    /** The results and state of findSwappingComparators(): */
+    std::vector<bool> * m_swapping = nullptr;
+    std::vector<std::size_t> m_stageOffsets;
+    bool m_exceeded = false;
+
+};
+
+constexpr std::size_t const PrefixSetVerifier::defaultMaxSetSize;
+constexpr std::size_t const PrefixSetVerifier::noComponent;
+
+/**
+  Tracks for every pair of lines (i, j) whether the value on line i is known
+  to be at most the value on line j for all inputs, using two bit matrices:
+  row i of m_le holds the lines j with x_i <= x_j and row i of m_ge holds the
+  lines j with x_j <= x_i. A comparator (a, b) never swaps if x_a <= x_b is
+  known. Otherwise, for every other line k, afterwards
+    min <= x_k  iff  x_a <= x_k or x_b <= x_k,
+    x_k <= min  iff  x_k <= x_a and x_k <= x_b,
+    max <= x_k  iff  x_a <= x_k and x_b <= x_k,
+    x_k <= max  iff  x_k <= x_a or x_k <= x_b,
+  which keeps the relation transitively closed. This is sound, but unlike
+  tracking the reachable 0-1 vectors does not find all comparators which never
+  swap.
+*/
+class OrderAnalyzer {
+
+public: /* Constants: */
+
+    /** The maximum number of lines, limiting the matrices to 2 * 8 MiB: */
+    constexpr static std::size_t const maxLines = 8192u;
+
+public: /* Methods: */
+
+    explicit OrderAnalyzer(std::size_t numLines)
+        : m_words((numLines + 63u) / 64u)
+        , m_le(numLines * m_words, 0u)
+        , m_ge(numLines * m_words, 0u)
+        , m_oldA(m_words)
+        , m_oldB(m_words)
+    {
+        for (std::size_t i = 0u; i < numLines; ++i) {
+            set(m_le, i, i, true);
+            set(m_ge, i, i, true);
+        }
+    }
+
+    /** \returns whether the comparator may swap before applying it. */
+    bool apply(std::size_t a, std::size_t b) {
+        if (get(m_le, a, b))
+            return false;
+        update(m_le, m_ge, a, b, false);
+        update(m_ge, m_le, a, b, true);
+        return true;
+    }
+
+private: /* Methods: */
+
+    bool get(std::vector<std::uint64_t> const & m,
+             std::size_t i,
+             std::size_t j) const noexcept
+    { return (m[i * m_words + j / 64u] >> (j % 64u)) & 1u; }
+
+    void set(std::vector<std::uint64_t> & m,
+             std::size_t i,
+             std::size_t j,
+             bool value) noexcept
+    {
+        auto & word = m[i * m_words + j / 64u];
+        auto const bit = std::uint64_t(1u) << (j % 64u);
+        word = value ? (word | bit) : (word & ~bit);
+    }
+
+    /**
+      Updates the rows of lines a and b of m and the corresponding columns of
+      its transpose t, where the new row of the minimum line a is the union of
+      the old rows for m_le and the intersection for m_ge, and vice versa.
+    */
+    void update(std::vector<std::uint64_t> & m,
+                std::vector<std::uint64_t> & t,
+                std::size_t a,
+                std::size_t b,
+                bool isGe)
+    {
+        auto const rowA = m.data() + a * m_words;
+        auto const rowB = m.data() + b * m_words;
+        std::copy(rowA, rowA + m_words, m_oldA.begin());
+        std::copy(rowB, rowB + m_words, m_oldB.begin());
+        for (std::size_t w = 0u; w < m_words; ++w) {
+            auto const either = m_oldA[w] | m_oldB[w];
+            auto const both = m_oldA[w] & m_oldB[w];
+            rowA[w] = isGe ? both : either;
+            rowB[w] = isGe ? either : both;
+        }
+        // Afterwards x_a <= x_b is known, but not x_b <= x_a:
+        set(m, a, a, true);
+        set(m, b, b, true);
+        set(m, a, b, !isGe);
+        set(m, b, a, isGe);
+
+        // Update the transpose where the rows changed:
+        for (auto const line : {a, b}) {
+            auto const row = m.data() + line * m_words;
+            auto const & old = (line == a) ? m_oldA : m_oldB;
+            for (std::size_t w = 0u; w < m_words; ++w) {
+                auto diff = row[w] ^ old[w];
+                for (std::size_t bit = 0u; diff; ++bit, diff >>= 1u)
+                    if (diff & 1u)
+                        set(t, w * 64u + bit, line, (row[w] >> bit) & 1u);
+            }
+        }
+    }
+
+private: /* Fields: */
+
+    std::size_t const m_words;
+    std::vector<std::uint64_t> m_le;
+    std::vector<std::uint64_t> m_ge;
+    std::vector<std::uint64_t> m_oldA;
+    std::vector<std::uint64_t> m_oldB;
+
+};
+
+constexpr std::size_t const OrderAnalyzer::maxLines;
+
+} // anonymous namespace
+
+bool Network::bruteForceIsSortingNetwork(std::size_t numThreads) const {
+    if (m_numInputs >= 64u)
+        throw std::length_error("Too many inputs to test all 0-1-patterns!");
+    return BitParallelVerifier<AllPatterns>(
+                *this,
+                AllPatterns(m_numInputs)).verify(numThreads);
+}
+
+bool Network::isSortingNetwork(std::size_t maxSetSize) const {
+    if (m_numInputs > 64u)
+        throw std::length_error("Too many inputs to verify!");
+    return PrefixSetVerifier(*this, maxSetSize).verify();
+}
+
+bool isMergingNetwork(Network const & network,
+                      std::size_t n0,
+                      std::size_t n1,
+                      std::size_t numThreads)
+{
+    assert(n0 <= network.numInputs());
+    assert(n1 == network.numInputs() - n0);
+    if ((n0 > std::numeric_limits<std::uint32_t>::max())
+        || (n1 > std::numeric_limits<std::uint32_t>::max()))
+        throw std::length_error("Too many inputs to test all merge patterns!");
+    return BitParallelVerifier<MergePatterns>(
+                network,
+                MergePatterns(n0, n1)).verify(numThreads);
+}
+
+void Network::removeRedundantComparators() {
+    std::vector<bool> swapping;
+    bool const exact =
+            (m_numInputs <= 64u)
+            && PrefixSetVerifier(*this, std::size_t(1u) << 20u)
+                    .findSwappingComparators(swapping);
+    if (!exact) {
+        if (m_numInputs > OrderAnalyzer::maxLines) {
+            compress();
+            return;
+        }
+        swapping.clear();
+        OrderAnalyzer analyzer(m_numInputs);
+        for (auto const & stage : m_stages)
+            for (auto const & c : stage.comparators())
+                swapping.push_back(analyzer.apply(c.min(), c.max()));
+    }
+
+    std::size_t i = 0u;
+    Stage::Comparators kept;
+    for (auto & stage : m_stages) {
+        kept.clear();
+        for (auto const & c : stage.comparators())
+            if (swapping[i++])
+                kept.emplace_back(c);
+        if (kept.size() != stage.numComparators())
+            stage = Stage(kept);
+    }
+    compress();
+}
+
+Network Network::withoutRedundantComparators() const {
+    Network n(*this);
+    n.removeRedundantComparators();
+    return n;
+}
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#include "NetworkView.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+
+
+namespace sharemind {
+namespace SortingNetwork {
+
+NetworkView::NetworkView(std::string const & path, bool verify) {
+    // The mapped data is accessed in place as native integers:
+    if (!Detail::hostIsLittleEndian())
+        throw std::runtime_error("NetworkView requires a little endian host!");
+
+    auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::system_error(errno,
+                                std::generic_category(),
+                                "Failed to open network file");
+    struct ::stat st;
+    if (::fstat(fd, &st) != 0) {
+        auto const e = errno;
+        ::close(fd);
+        throw std::system_error(e,
+                                std::generic_category(),
+                                "Failed to stat network file");
+    }
+    if (static_cast<std::uint64_t>(st.st_size)
+        < Detail::networkFileHeaderSize)
+    {
+        ::close(fd);
+        throw InvalidNetworkFormat("Truncated network data!");
+    }
+    auto const size = static_cast<std::size_t>(st.st_size);
+    auto const mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    auto const e = errno;
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        throw std::system_error(e,
+                                std::generic_category(),
+                                "Failed to map network file");
+    m_mapping = mapping;
+    m_mappingSize = size;
+
+    try {
+        auto const data = static_cast<unsigned char const *>(mapping);
+        m_header = Detail::decodeNetworkFileHeader(data);
+        if (Detail::networkFilePayloadSize(m_header)
+            > size - Detail::networkFileHeaderSize)
+            throw InvalidNetworkFormat("Truncated network data!");
+        auto const payload = data + Detail::networkFileHeaderSize;
+        if (verify)
+            Detail::validateNetworkFilePayload(m_header, payload, true);
+        m_numInputs = static_cast<std::size_t>(m_header.numInputs);
+        m_numStages = static_cast<std::size_t>(m_header.numStages);
+        m_numComparators = static_cast<std::size_t>(m_header.numComparators);
+        m_stageOffsets = reinterpret_cast<std::uint64_t const *>(payload);
+        m_comparators = payload + (m_numStages + 1u) * 8u;
+    } catch (...) {
+        ::munmap(m_mapping, m_mappingSize);
+        throw;
+    }
+}
+
+NetworkView::NetworkView(NetworkView && move) noexcept
+    : m_mapping(move.m_mapping)
+    , m_mappingSize(move.m_mappingSize)
+    , m_header(move.m_header)
+    , m_numInputs(move.m_numInputs)
+    , m_numStages(move.m_numStages)
+    , m_numComparators(move.m_numComparators)
+    , m_stageOffsets(move.m_stageOffsets)
+    , m_comparators(move.m_comparators)
+{ move.m_mapping = nullptr; }
+
+NetworkView & NetworkView::operator=(NetworkView && move) noexcept {
+    if (this != &move) {
+        if (m_mapping)
+            ::munmap(m_mapping, m_mappingSize);
+        m_mapping = move.m_mapping;
+        m_mappingSize = move.m_mappingSize;
+        m_header = move.m_header;
+        m_numInputs = move.m_numInputs;
+        m_numStages = move.m_numStages;
+        m_numComparators = move.m_numComparators;
+        m_stageOffsets = move.m_stageOffsets;
+        m_comparators = move.m_comparators;
+        move.m_mapping = nullptr;
+    }
+    return *this;
+}
+
+NetworkView::~NetworkView() noexcept {
+    if (m_mapping)
+        ::munmap(m_mapping, m_mappingSize);
+}
+
+Network NetworkView::toNetwork() const {
+    auto const payload = static_cast<unsigned char const *>(m_mapping)
+                         + Detail::networkFileHeaderSize;
+    // The line indexes are used as indexes when decoding, even if unverified:
+    Detail::validateNetworkFilePayload(m_header, payload, false);
+    return Detail::decodeNetworkFilePayload(m_header, payload);
+}
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
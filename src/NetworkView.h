@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_NETWORKVIEW_H
+#define SHAREMIND_LIBSORTNETWORK_NETWORKVIEW_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <sharemind/Concepts.h>
+#include <sharemind/Iterator.h>
+#include <string>
+#include <type_traits>
+#include "Exchange.h"
+#include "Network.h"
+#include "NetworkFormat.h"
+
+
+namespace sharemind {
+namespace SortingNetwork {
+
+/**
+  A read-only view of a comparator network saved to a file by Network::save().
+  The file is mapped into memory and the comparators are applied directly from
+  the mapping without copying, so processes viewing the same file share its
+  pages through the page cache.
+*/
+class NetworkView {
+
+public: /* Methods: */
+
+    /**
+      Maps a network file into memory.
+      \param[in] path The path to the file.
+      \param[in] verify Whether to verify the checksum and all line indexes of
+                        the file. This reads the whole file once, hence should
+                        only be skipped for trusted files.
+      \throws std::system_error if the file could not be opened or mapped.
+      \throws InvalidNetworkFormat if the file is truncated or invalid.
+      \throws std::runtime_error if the host is not little endian.
+    */
+    explicit NetworkView(std::string const & path, bool verify = true);
+
+    NetworkView(NetworkView && move) noexcept;
+    NetworkView(NetworkView const &) = delete;
+
+    NetworkView & operator=(NetworkView && move) noexcept;
+    NetworkView & operator=(NetworkView const &) = delete;
+
+    /** Unmaps the file. */
+    ~NetworkView() noexcept;
+
+    std::size_t numInputs() const noexcept { return m_numInputs; }
+
+    std::size_t numStages() const noexcept { return m_numStages; }
+
+    /** \returns the total amount of comparators in this network. */
+    std::size_t numComparators() const noexcept { return m_numComparators; }
+
+    /** \returns the number of comparators for a given stage in this network. */
+    std::size_t numComparators(std::size_t stageIndex) const noexcept {
+        assert(stageIndex < m_numStages);
+        return static_cast<std::size_t>(m_stageOffsets[stageIndex + 1u]
+                                        - m_stageOffsets[stageIndex]);
+    }
+
+    /**
+      \returns a copy of the viewed network.
+      \throws InvalidNetworkFormat if the viewed network is invalid, e.g. if a
+                                   stage uses a line more than once.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    Network toNetwork() const;
+
+    /**
+      Applies this comparator network to a range of values.
+
+      \pre The number of values pointed to must be at least numInputs().
+      \param[in] first Iterator to the first value to sort.
+    */
+    template <typename It,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type),
+                    Swappable(typename std::iterator_traits<It>::value_type))>
+    void sortValues(It first) const {
+        using T = typename std::iterator_traits<It>::value_type;
+        auto less = [](T const & a, T const & b) { return a < b; };
+        sortValues<It, decltype(less) &>(first, less, BranchingExchange());
+    }
+
+    /**
+      Applies this comparator network to a range of values.
+
+      \pre The number of values pointed to must be at least numInputs().
+      \param[in] first Iterator to the first value to sort.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+    */
+    template <typename It,
+              typename Comp,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    Swappable(typename std::iterator_traits<It>::value_type),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValues(It first, Comp comp) const
+    { sortValues<It, Comp &>(first, comp, BranchingExchange()); }
+
+    /**
+      Applies this comparator network to a range of values using the given
+      exchange policy and operator<() for comparisons.
+
+      \pre The number of values pointed to must be at least numInputs().
+      \param[in] first Iterator to the first value to sort.
+      \param[in] exchange The exchange policy (see Exchange.h), callable as
+                          exchange(first[i], first[j], doSwap) for any valid i
+                          and j, which must swap its first two arguments if and
+                          only if doSwap is true.
+    */
+    template <typename It,
+              typename Exchange,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type)),
+              typename std::enable_if<
+                    Detail::IsExchangePolicy<
+                            Exchange,
+                            typename std::iterator_traits<It>::value_type
+                    >::value,
+                    int>::type = 0>
+    void sortValues(It first, Exchange exchange) const {
+        using T = typename std::iterator_traits<It>::value_type;
+        auto less = [](T const & a, T const & b) { return a < b; };
+        sortValues<It, decltype(less) &, Exchange &>(first, less, exchange);
+    }
+
+    /**
+      Applies this comparator network to a range of values using the given
+      exchange policy.
+
+      \pre The number of values pointed to must be at least numInputs().
+      \param[in] first Iterator to the first value to sort.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+      \param[in] exchange The exchange policy (see Exchange.h), callable as
+                          exchange(first[i], first[j], doSwap) for any valid i
+                          and j, which must swap its first two arguments if and
+                          only if doSwap is true.
+    */
+    template <typename It,
+              typename Comp,
+              typename Exchange,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValues(It first, Comp comp, Exchange exchange) const {
+        if (m_header.indexSize == 2u) {
+            sortValues_<std::uint16_t, It, Comp &, Exchange &>(first,
+                                                               comp,
+                                                               exchange);
+        } else {
+            sortValues_<std::uint32_t, It, Comp &, Exchange &>(first,
+                                                               comp,
+                                                               exchange);
+        }
+    }
+
+private: /* Methods: */
+
+    template <typename Index, typename It, typename Comp, typename Exchange>
+    void sortValues_(It first, Comp comp, Exchange exchange) const {
+        using D = typename std::iterator_traits<It>::difference_type;
+        auto const indexes = static_cast<Index const *>(m_comparators);
+        auto const end = indexes + 2u * m_numComparators;
+        for (auto it = indexes; it != end; it += 2u) {
+            auto & minValue = first[static_cast<D>(it[0u])];
+            auto & maxValue = first[static_cast<D>(it[1u])];
+            exchange(minValue, maxValue, comp(maxValue, minValue));
+        }
+    }
+
+private: /* Fields: */
+
+    void * m_mapping = nullptr;
+    std::size_t m_mappingSize = 0u;
+
+    Detail::NetworkFileHeader m_header;
+    std::size_t m_numInputs;
+    std::size_t m_numStages;
+    std::size_t m_numComparators;
+
+    /** The stage offsets and the line indexes within the mapping: */
+    std::uint64_t const * m_stageOffsets;
+    void const * m_comparators;
+
+};
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_NETWORKVIEW_H */
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#include "ParallelExecutor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace {
+
+/**
+  Splits the comparators of the given network into phases, i.e. maximal runs of
+  consecutive stages which touch pairwise disjoint sets of lines.
+  \returns the offsets of the first comparators of all phases, followed by the
+           total number of comparators.
+*/
+std::vector<std::size_t> computePhaseOffsets(CompiledNetwork const & network) {
+    std::vector<std::size_t> phaseOffsets;
+    phaseOffsets.emplace_back(0u);
+    auto const offsets = network.stageOffsets();
+    auto const mins = network.minIndexes();
+    auto const maxs = network.maxIndexes();
+
+    // The 1-based index of the last phase which used each line:
+    std::vector<std::size_t> linePhases(network.numInputs(), 0u);
+    std::size_t phase = 1u;
+    for (std::size_t s = 0u; s < network.numStages(); ++s) {
+        auto const begin = offsets[s];
+        auto const end = offsets[s + 1u];
+        for (auto i = begin; i < end; ++i) {
+            if ((linePhases[mins[i]] == phase)
+                || (linePhases[maxs[i]] == phase))
+            {
+                phaseOffsets.emplace_back(begin);
+                ++phase;
+                break;
+            }
+        }
+        for (auto i = begin; i < end; ++i) {
+            linePhases[mins[i]] = phase;
+            linePhases[maxs[i]] = phase;
+        }
+    }
+    phaseOffsets.emplace_back(network.numComparators());
+    return phaseOffsets;
+}
+
+} // anonymous namespace
+
+constexpr std::size_t const ParallelExecutor::defaultGrainSize;
+
+struct ParallelExecutor::Inner {
+
+/* Methods: */
+
+    Inner(std::size_t numThreads, std::size_t grainSize)
+        : m_grainSize(grainSize ? grainSize : defaultGrainSize)
+    {
+        if (!numThreads)
+            numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        m_workers.reserve(numThreads - 1u);
+        try {
+            for (std::size_t i = 1u; i < numThreads; ++i)
+                m_workers.emplace_back([this]() noexcept { workerLoop(); });
+        } catch (...) {
+            stopWorkers();
+            throw;
+        }
+    }
+
+    ~Inner() noexcept { stopWorkers(); }
+
+    void stopWorkers() noexcept {
+        {
+            std::lock_guard<std::mutex> const guard(m_mutex);
+            m_stop = true;
+        }
+        m_wakeCondition.notify_all();
+        for (auto & worker : m_workers)
+            worker.join();
+        m_workers.clear();
+    }
+
+    void workerLoop() noexcept {
+        std::size_t seenGeneration = 0u;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeCondition.wait(
+                            lock,
+                            [this, seenGeneration]() noexcept
+                            { return m_stop || m_generation != seenGeneration; });
+                if (m_stop)
+                    return;
+                seenGeneration = m_generation;
+            }
+            runChunks();
+            {
+                std::lock_guard<std::mutex> const guard(m_mutex);
+                if (--m_numBusyWorkers == 0u)
+                    m_doneCondition.notify_one();
+            }
+        }
+    }
+
+    /** Runs chunks of the current phase until none are left. */
+    void runChunks() noexcept {
+        for (;;) {
+            auto const begin = m_next.fetch_add(m_grainSize);
+            if (begin >= m_end)
+                return;
+            try {
+                (*m_chunkFunction)(begin, std::min(begin + m_grainSize, m_end));
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> const guard(m_mutex);
+                    if (!m_error)
+                        m_error = std::current_exception();
+                }
+                // Skip the remaining chunks of this phase:
+                m_next.store(m_end);
+                return;
+            }
+        }
+    }
+
+    void runPhase(std::size_t begin, std::size_t end) {
+        if (m_workers.empty() || (end - begin <= m_grainSize)) {
+            (*m_chunkFunction)(begin, end);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> const guard(m_mutex);
+            m_end = end;
+            m_next.store(begin);
+            m_numBusyWorkers = m_workers.size();
+            ++m_generation;
+        }
+        m_wakeCondition.notify_all();
+        runChunks();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCondition.wait(lock,
+                             [this]() noexcept
+                             { return m_numBusyWorkers == 0u; });
+        if (m_error) {
+            auto error(std::move(m_error));
+            m_error = nullptr;
+            std::rethrow_exception(std::move(error));
+        }
+    }
+
+/* Fields: */
+
+    std::size_t const m_grainSize;
+    std::vector<std::thread> m_workers;
+
+    /** Serializes calls to ParallelExecutor::execute(): */
+    std::mutex m_executeMutex;
+
+    /** Protects the fields below, except for m_next: */
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_doneCondition;
+    bool m_stop = false;
+    std::size_t m_generation = 0u;
+    std::size_t m_numBusyWorkers = 0u;
+    std::exception_ptr m_error;
+
+    /* The current phase. These are only modified while no worker is busy: */
+    ChunkFunction const * m_chunkFunction = nullptr;
+    std::size_t m_end = 0u;
+    std::atomic<std::size_t> m_next{0u};
+
+};
+
+ParallelExecutor::ParallelExecutor(std::size_t numThreads,
+                                   std::size_t grainSize)
+    : m_inner(new Inner(numThreads, grainSize))
+{}
+
+ParallelExecutor::~ParallelExecutor() noexcept = default;
+
+std::size_t ParallelExecutor::numThreads() const noexcept
+{ return m_inner->m_workers.size() + 1u; }
+
+std::size_t ParallelExecutor::grainSize() const noexcept
+{ return m_inner->m_grainSize; }
+
+void ParallelExecutor::execute(CompiledNetwork const & network,
+                               ChunkFunction chunkFunction)
+{
+    auto & inner = *m_inner;
+    std::lock_guard<std::mutex> const guard(inner.m_executeMutex);
+    auto const phaseOffsets(computePhaseOffsets(network));
+    inner.m_chunkFunction = &chunkFunction;
+    for (std::size_t i = 1u; i < phaseOffsets.size(); ++i) {
+        assert(phaseOffsets[i - 1u] <= phaseOffsets[i]);
+        inner.runPhase(phaseOffsets[i - 1u], phaseOffsets[i]);
+    }
+    inner.m_chunkFunction = nullptr;
+}
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_PARALLELEXECUTOR_H
+#define SHAREMIND_LIBSORTNETWORK_PARALLELEXECUTOR_H
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <sharemind/Concepts.h>
+#include <sharemind/Iterator.h>
+#include <utility>
+#include "CompiledNetwork.h"
+
+
+namespace sharemind {
+namespace SortingNetwork {
+
+/**
+  Applies compiled comparator networks to large inputs using a pool of worker
+  threads. The comparators of each stage are split into chunks of a given grain
+  size which are distributed over the threads, with a barrier between stages.
+  Consecutive stages which touch disjoint sets of lines are executed as a
+  single phase without a barrier in between.
+*/
+class ParallelExecutor {
+
+public: /* Constants: */
+
+    constexpr static std::size_t const defaultGrainSize = 4096u;
+
+public: /* Methods: */
+
+    /**
+      Creates a new executor and starts its worker threads.
+      \param[in] numThreads The total number of threads to use, including the
+                            thread calling sortValues(). If zero, the number of
+                            hardware threads is used.
+      \param[in] grainSize The maximum number of comparators in a chunk of work
+                           handed to a thread. Phases with no more comparators
+                           than this are executed by the calling thread alone.
+                           If zero, defaultGrainSize is used.
+      \throws std::system_error if a worker thread could not be started.
+    */
+    explicit ParallelExecutor(std::size_t numThreads = 0u,
+                              std::size_t grainSize = defaultGrainSize);
+
+    ParallelExecutor(ParallelExecutor &&) = delete;
+    ParallelExecutor(ParallelExecutor const &) = delete;
+
+    ParallelExecutor & operator=(ParallelExecutor &&) = delete;
+    ParallelExecutor & operator=(ParallelExecutor const &) = delete;
+
+    /** Stops and joins all worker threads. */
+    ~ParallelExecutor() noexcept;
+
+    /** \returns the total number of threads used, including the caller. */
+    std::size_t numThreads() const noexcept;
+
+    /** \returns the maximum number of comparators in a chunk of work. */
+    std::size_t grainSize() const noexcept;
+
+    /**
+      Applies the given comparator network to the given range of values.
+      Calls from different threads are serialized.
+      \param[in] network The comparator network to apply.
+      \param[in] first Iterator to the first value to sort.
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    template <typename It,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type),
+                    Swappable(typename std::iterator_traits<It>::value_type))>
+    void sortValues(CompiledNetwork const & network, It first) {
+        auto const mins = network.minIndexes();
+        auto const maxs = network.maxIndexes();
+        execute(network,
+                [first, mins, maxs](std::size_t begin, std::size_t end) {
+                    for (auto i = begin; i < end; ++i) {
+                        auto & minValue = first[mins[i]];
+                        auto & maxValue = first[maxs[i]];
+                        if (maxValue < minValue)
+                            std::swap(minValue, maxValue);
+                    }
+                });
+    }
+
+    /**
+      Applies the given comparator network to the given range of values.
+      Calls from different threads are serialized.
+      \param[in] network The comparator network to apply.
+      \param[in] first Iterator to the first value to sort.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      concurrently from multiple threads and must not modify
+                      the objects passed to it.
+      \pre The number of values pointed to must be at least the number of inputs
+           of the comparator network.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+      \throws any exception thrown by comp.
+    */
+    template <typename It,
+              typename Comp,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    Swappable(typename std::iterator_traits<It>::value_type),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValues(CompiledNetwork const & network, It first, Comp comp) {
+        auto const mins = network.minIndexes();
+        auto const maxs = network.maxIndexes();
+        execute(network,
+                [first, mins, maxs, &comp](std::size_t begin, std::size_t end)
+                {
+                    for (auto i = begin; i < end; ++i) {
+                        auto & minValue = first[mins[i]];
+                        auto & maxValue = first[maxs[i]];
+                        if (comp(maxValue, minValue))
+                            std::swap(minValue, maxValue);
+                    }
+                });
+    }
+
+private: /* Types: */
+
+    /** Applies the comparators with indexes in the given range: */
+    using ChunkFunction = std::function<void (std::size_t, std::size_t)>;
+
+    struct Inner;
+
+private: /* Methods: */
+
+    void execute(CompiledNetwork const & network, ChunkFunction chunkFunction);
+
+private: /* Fields: */
+
+    std::unique_ptr<Inner> m_inner;
+
+};
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_PARALLELEXECUTOR_H */
@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_PERMUTATION_H
+#define SHAREMIND_LIBSORTNETWORK_PERMUTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <sharemind/Concepts.h>
+#include <sharemind/Iterator.h>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace Detail {
+
+/** A sort key along with the index of the input it was extracted from: */
+template <typename Key>
+struct KeyIndexPair {
+    Key key;
+    std::uint32_t index;
+};
+
+template <typename NetworkType,
+          typename It,
+          typename KeyFunction,
+          typename Comp,
+          typename Key = typename std::decay<
+                decltype(std::declval<KeyFunction &>()(
+                             *std::declval<It &>()))>::type>
+std::vector<KeyIndexPair<Key> > sortKeyIndexPairs(
+        NetworkType const & network,
+        It first,
+        KeyFunction & keyFunction,
+        Comp & comp)
+{
+    auto const numInputs = network.numInputs();
+    if (numInputs > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("Number of inputs exceeds implementation "
+                                "limits!");
+    using D = typename std::iterator_traits<It>::difference_type;
+    std::vector<KeyIndexPair<Key> > pairs;
+    pairs.reserve(numInputs);
+    for (std::size_t i = 0u; i < numInputs; ++i)
+        pairs.emplace_back(
+                KeyIndexPair<Key>{keyFunction(first[static_cast<D>(i)]),
+                                  static_cast<std::uint32_t>(i)});
+    network.sortValues(pairs.data(),
+                       [&comp](KeyIndexPair<Key> const & lhs,
+                               KeyIndexPair<Key> const & rhs)
+                       { return comp(lhs.key, rhs.key); });
+    return pairs;
+}
+
+template <typename NetworkType, typename It>
+std::vector<std::uint32_t> sortIndexes(NetworkType const & network, It first) {
+    auto const numInputs = network.numInputs();
+    if (numInputs > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("Number of inputs exceeds implementation "
+                                "limits!");
+    using D = typename std::iterator_traits<It>::difference_type;
+    std::vector<std::uint32_t> indexes(numInputs);
+    for (std::size_t i = 0u; i < numInputs; ++i)
+        indexes[i] = static_cast<std::uint32_t>(i);
+    network.sortValues(indexes.data(),
+                       [&first](std::uint32_t const lhs,
+                                std::uint32_t const rhs)
+                       {
+                           return first[static_cast<D>(lhs)]
+                                  < first[static_cast<D>(rhs)];
+                       });
+    return indexes;
+}
+
+struct LessKey {
+    template <typename T>
+    bool operator()(T const & lhs, T const & rhs) const { return lhs < rhs; }
+};
+
+} /* namespace Detail { */
+
+/**
+  Computes the permutation which the given comparator network applies to the
+  given range of values when sorting it, i.e. writes to out[i] the index of the
+  value which sortValues() would put on the i-th line. Instead of the values,
+  the network is applied to tightly packed pairs of keys extracted from the
+  values and 32-bit input indexes, such that large values can afterwards be
+  sorted with a single move each, e.g. as result[i] = first[out[i]]. Since the
+  pairs hold copies of the keys, the keys should be small, e.g. single fields
+  of wide records.
+  \param[in] network The comparator network (e.g. a Network or a
+                     CompiledNetwork) to apply.
+  \param[in] first Iterator to the first value.
+  \param[in] out Iterator to the output range of indexes.
+  \param[in] keyFunction The function object used to extract the sort key
+                         from a value, callable as keyFunction(first[i]).
+  \param[in] comp The comparison function object which returns true if its
+                  first argument is less than (i.e. is ordered before) its
+                  second argument. The comparison function object must be
+                  callable as comp(k1, k2) for any keys k1 and k2 returned by
+                  keyFunction and must not modify the objects passed to it.
+  \pre The number of values pointed to must be at least the number of inputs
+       of the comparator network, and the output range must have room for as
+       many indexes.
+  \throws std::length_error if the number of inputs of the network exceeds
+                            implementation limits.
+  \throws std::bad_alloc an out-of-memory condition was encountered.
+*/
+template <typename NetworkType,
+          typename It,
+          typename OutIt,
+          typename KeyFunction,
+          typename Comp,
+          SHAREMIND_REQUIRES_CONCEPTS(RandomAccessIterator(It),
+                                      OutputIterator(OutIt, std::uint32_t))>
+void computePermutation(NetworkType const & network,
+                        It first,
+                        OutIt out,
+                        KeyFunction keyFunction,
+                        Comp comp)
+{
+    for (auto const & pair
+         : Detail::sortKeyIndexPairs(network, first, keyFunction, comp))
+    {
+        *out = pair.index;
+        ++out;
+    }
+}
+
+/**
+  Computes the permutation which the given comparator network applies to the
+  given range of values when sorting it by the keys extracted from the values
+  in ascending order, see computePermutation(network, first, out, keyFunction,
+  comp) for details.
+*/
+template <typename NetworkType,
+          typename It,
+          typename OutIt,
+          typename KeyFunction,
+          SHAREMIND_REQUIRES_CONCEPTS(RandomAccessIterator(It),
+                                      OutputIterator(OutIt, std::uint32_t))>
+void computePermutation(NetworkType const & network,
+                        It first,
+                        OutIt out,
+                        KeyFunction keyFunction)
+{
+    computePermutation(network,
+                       std::move(first),
+                       std::move(out),
+                       std::move(keyFunction),
+                       Detail::LessKey());
+}
+
+/**
+  Computes the permutation which the given comparator network applies to the
+  given range of values when sorting them in ascending order, see
+  computePermutation(network, first, out, keyFunction, comp) for details.
+  Without a key function, the network is applied to the 32-bit input indexes
+  alone, comparing the values they refer to as first[i] < first[j]. Every
+  comparison then reads the values through an extra indirection, so sorting
+  wide records by a small key is usually faster with a key function.
+*/
+template <typename NetworkType,
+          typename It,
+          typename OutIt,
+          SHAREMIND_REQUIRES_CONCEPTS(RandomAccessIterator(It),
+                                      OutputIterator(OutIt, std::uint32_t))>
+void computePermutation(NetworkType const & network, It first, OutIt out) {
+    for (auto const index : Detail::sortIndexes(network, std::move(first))) {
+        *out = index;
+        ++out;
+    }
+}
+
+/**
+  Computes the inverse of the permutation which the given comparator network
+  applies to the given range of values when sorting it, i.e. writes to out[i]
+  the index of the line onto which sortValues() would put the i-th value. Like
+  computePermutation(), this only moves pairs of keys and 32-bit indexes, and
+  large values can afterwards be sorted as result[out[i]] = first[i].
+  \param[in] network The comparator network (e.g. a Network or a
+                     CompiledNetwork) to apply.
+  \param[in] first Iterator to the first value.
+  \param[in] out Iterator to the output range of indexes.
+  \param[in] keyFunction The function object used to extract the sort key
+                         from a value, callable as keyFunction(first[i]).
+  \param[in] comp The comparison function object which returns true if its
+                  first argument is less than (i.e. is ordered before) its
+                  second argument. The comparison function object must be
+                  callable as comp(k1, k2) for any keys k1 and k2 returned by
+                  keyFunction and must not modify the objects passed to it.
+  \pre The number of values pointed to must be at least the number of inputs
+       of the comparator network, and the output range must have room for as
+       many indexes.
+  \throws std::length_error if the number of inputs of the network exceeds
+                            implementation limits.
+  \throws std::bad_alloc an out-of-memory condition was encountered.
+*/
+template <typename NetworkType,
+          typename It,
+          typename OutIt,
+          typename KeyFunction,
+          typename Comp,
+          SHAREMIND_REQUIRES_CONCEPTS(RandomAccessIterator(It),
+                                      RandomAccessIterator(OutIt))>
+void computeInversePermutation(NetworkType const & network,
+                               It first,
+                               OutIt out,
+                               KeyFunction keyFunction,
+                               Comp comp)
+{
+    using D = typename std::iterator_traits<OutIt>::difference_type;
+    std::uint32_t line = 0u;
+    for (auto const & pair
+         : Detail::sortKeyIndexPairs(network, first, keyFunction, comp))
+        out[static_cast<D>(pair.index)] = line++;
+}
+
+/**
+  Computes the inverse of the permutation which the given comparator network
+  applies to the given range of values when sorting it by the keys extracted
+  from the values in ascending order, see computeInversePermutation(network,
+  first, out, keyFunction, comp) for details.
+*/
+template <typename NetworkType,
+          typename It,
+          typename OutIt,
+          typename KeyFunction,
+          SHAREMIND_REQUIRES_CONCEPTS(RandomAccessIterator(It),
+                                      RandomAccessIterator(OutIt))>
+void computeInversePermutation(NetworkType const & network,
+                               It first,
+                               OutIt out,
+                               KeyFunction keyFunction)
+{
+    computeInversePermutation(network,
+                              std::move(first),
+                              std::move(out),
+                              std::move(keyFunction),
+                              Detail::LessKey());
+}
+
+/**
+  Computes the inverse of the permutation which the given comparator network
+  applies to the given range of values when sorting them in ascending order,
+  see computeInversePermutation(network, first, out, keyFunction, comp) for
+  details. Like computePermutation(network, first, out), this applies the
+  network to the 32-bit input indexes alone, so sorting wide records by a
+  small key is usually faster with a key function.
+*/
+template <typename NetworkType,
+          typename It,
+          typename OutIt,
+          SHAREMIND_REQUIRES_CONCEPTS(RandomAccessIterator(It),
+                                      RandomAccessIterator(OutIt))>
+void computeInversePermutation(NetworkType const & network,
+                               It first,
+                               OutIt out)
+{
+    using D = typename std::iterator_traits<OutIt>::difference_type;
+    std::uint32_t line = 0u;
+    for (auto const index : Detail::sortIndexes(network, std::move(first)))
+        out[static_cast<D>(index)] = line++;
+}
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_PERMUTATION_H */
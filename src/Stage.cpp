@@ -36,6 +36,23 @@ namespace SortingNetwork {
 Stage::Stage() noexcept
 { static_assert(std::is_nothrow_default_constructible<Comparators>::value,""); }
 
+Stage::Stage(Comparators comparators)
+    : m_comparators(std::move(comparators))
+{
+    if (!std::is_sorted(m_comparators.begin(), m_comparators.end()))
+        std::sort(m_comparators.begin(), m_comparators.end());
+    #ifndef NDEBUG
+    std::vector<std::size_t> lines;
+    lines.reserve(m_comparators.size() * 2u);
+    for (auto const & comp : m_comparators) {
+        lines.emplace_back(comp.min());
+        lines.emplace_back(comp.max());
+    }
+    std::sort(lines.begin(), lines.end());
+    assert(std::adjacent_find(lines.begin(), lines.end()) == lines.end());
+    #endif
+}
+
 Stage::~Stage() noexcept = default;
 
 Stage::Stage(Stage &&) noexcept = default;
@@ -46,23 +63,48 @@ Stage & Stage::operator=(Stage const &) = default;
 
 void Stage::addComparator(Comparator comparator) {
     assert(getConflictsWith(comparator) == NoConflict);
+    if (m_hasLineIndex) {
+        auto const size = std::max(comparator.min(), comparator.max()) + 1u;
+        if (m_lineIndex.size() < size)
+            m_lineIndex.resize(size, 0u);
+    }
     auto posIt(std::lower_bound(m_comparators.begin(),
                                 m_comparators.end(),
                                 comparator));
-    m_comparators.insert(std::move(posIt), std::move(comparator));
+    posIt = m_comparators.insert(std::move(posIt), std::move(comparator));
     assert(std::is_sorted(m_comparators.begin(), m_comparators.end()));
+    if (m_hasLineIndex)
+        addToLineIndex(*posIt);
 }
 
 void Stage::removeComparator(std::size_t index) noexcept {
     assert(index < m_comparators.size());
-    m_comparators.erase(
-                std::next(m_comparators.begin(),
-                          static_cast<Comparators::difference_type>(index)));
+    auto const it(std::next(m_comparators.begin(),
+                            static_cast<Comparators::difference_type>(index)));
+    if (m_hasLineIndex) {
+        m_lineIndex[it->min()] = 0u;
+        m_lineIndex[it->max()] = 0u;
+    }
+    m_comparators.erase(it);
 }
 
-Stage::ConflictType Stage::getConflictsWith(Comparator const & c) {
+Stage::ConflictType Stage::getConflictsWith(Comparator const & c)
+        const noexcept
+{
     auto const cMin(c.min());
     auto const cMax(c.max());
+    if (m_hasLineIndex) {
+        if (cMin < m_lineIndex.size()) {
+            if (auto const entry = m_lineIndex[cMin])
+                return (entry == (((cMax + 1u) << 1u) | 1u))
+                       ? ComparatorAlreadyPresent
+                       : Conflict;
+        }
+        return ((cMax < m_lineIndex.size()) && m_lineIndex[cMax])
+               ? Conflict
+               : NoConflict;
+    }
+
     for (auto const & c2: m_comparators) {
         auto const c2Min(c2.min());
 
@@ -83,9 +125,47 @@ Stage::ConflictType Stage::getConflictsWith(Comparator const & c) {
   return NoConflict;
 }
 
+void Stage::buildLineIndex() {
+    m_hasLineIndex = false;
+    std::size_t size = 0u;
+    for (auto const & comp : m_comparators)
+        size = std::max(size, std::max(comp.min(), comp.max()) + 1u);
+    std::fill(m_lineIndex.begin(), m_lineIndex.end(), 0u);
+    if (m_lineIndex.size() < size)
+        m_lineIndex.resize(size, 0u);
+    for (auto const & comp : m_comparators)
+        addToLineIndex(comp);
+    m_hasLineIndex = true;
+}
+
+void Stage::clearLineIndex() noexcept {
+    m_hasLineIndex = false;
+    std::vector<std::size_t>().swap(m_lineIndex);
+}
+
+void Stage::addToLineIndex(Comparator const & comparator) noexcept {
+    auto const min(comparator.min());
+    auto const max(comparator.max());
+    assert(min < m_lineIndex.size());
+    assert(max < m_lineIndex.size());
+    m_lineIndex[min] = ((max + 1u) << 1u) | 1u;
+    m_lineIndex[max] = (min + 1u) << 1u;
+}
+
+void Stage::refreshLineIndex() noexcept {
+    if (!m_hasLineIndex)
+        return;
+    try {
+        buildLineIndex();
+    } catch (...) {
+        clearLineIndex();
+    }
+}
+
 void Stage::invert() noexcept {
     for (auto & comp : m_comparators)
         comp.invert();
+    refreshLineIndex();
 }
 
 void Stage::shift(std::size_t offset, std::size_t numInputs) noexcept {
@@ -96,6 +176,7 @@ void Stage::shift(std::size_t offset, std::size_t numInputs) noexcept {
         return;
     for (auto & comp : m_comparators)
         comp.shift(offset, numInputs);
+    refreshLineIndex();
 }
 
 void Stage::canonicalize()
@@ -104,6 +185,7 @@ void Stage::canonicalize()
 void Stage::swapIndexes(std::size_t index1, std::size_t index2) noexcept {
     for (auto & comp : m_comparators)
         comp.swapIndexes(index1, index2);
+    refreshLineIndex();
 }
 
 void Stage::removeInput(std::size_t input) noexcept {
@@ -120,6 +202,7 @@ void Stage::removeInput(std::size_t input) noexcept {
         }
 
     }
+    refreshLineIndex();
 }
 
 int Stage::compare(Stage const & other) const noexcept {
@@ -139,6 +222,8 @@ int Stage::compare(Stage const & other) const noexcept {
 void Stage::swap(Stage & other) noexcept {
     static_assert(noexcept(std::swap(m_comparators, other.m_comparators)), "");
     std::swap(m_comparators, other.m_comparators);
+    std::swap(m_lineIndex, other.m_lineIndex);
+    std::swap(m_hasLineIndex, other.m_hasLineIndex);
 }
 
 bool operator<(Stage const & lhs, Stage const & rhs) noexcept
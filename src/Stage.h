@@ -28,9 +28,11 @@
 #include <iterator>
 #include <sharemind/Concepts.h>
 #include <sharemind/Iterator.h>
+#include <type_traits>
 #include <vector>
 #include <utility>
 #include "Comparator.h"
+#include "Exchange.h"
 
 
 namespace sharemind {
@@ -53,6 +55,15 @@ public: /* Methods: */
     /** Creates an empty stage. */
     Stage() noexcept;
 
+    /**
+      Creates a stage from the given comparators at once, which is faster than
+      adding them one by one using addComparator().
+      \param[in] comparators The comparators of the stage, in any order.
+      \pre No two comparators may use the same line.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    explicit Stage(Comparators comparators);
+
     Stage(Stage &&) noexcept;
     Stage(Stage const &);
 
@@ -76,6 +87,7 @@ public: /* Methods: */
       comparator using on of the line already exists in this stage) an error is
       returned.
       \param[in] comparator A reference to the comparator to add.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
     */
     void addComparator(Comparator comparator);
 
@@ -128,22 +140,192 @@ public: /* Methods: */
                             Comp,
                             typename std::iterator_traits<It>::value_type,
                             typename std::iterator_traits<It>::value_type))>
-    void sortValues(It first, Comp comp) const {
+    void sortValues(It first, Comp comp) const
+    { sortValues<It, Comp &>(first, comp, BranchingExchange()); }
+
+    /**
+      Applies this Stage to a range of values using the given exchange policy
+      and operator<() for comparisons.
+
+      \pre The number of values pointed to must be at least the number of
+           inputs of the comparator network.
+      \param[in] first Iterator to the first value to sort.
+      \param[in] exchange The exchange policy (see Exchange.h), callable as
+                          exchange(first[i], first[j], doSwap) for any valid i
+                          and j, which must swap its first two arguments if and
+                          only if doSwap is true.
+    */
+    template <typename It,
+              typename Exchange,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type)),
+              typename std::enable_if<
+                    Detail::IsExchangePolicy<
+                            Exchange,
+                            typename std::iterator_traits<It>::value_type
+                    >::value,
+                    int>::type = 0>
+    void sortValues(It first, Exchange exchange) const {
+        using T = typename std::iterator_traits<It>::value_type;
+        auto less = [](T const & a, T const & b) { return a < b; };
+        sortValues<It, decltype(less) &, Exchange &>(first, less, exchange);
+    }
+
+    /**
+      Applies this Stage to a range of values using the given exchange policy.
+
+      \pre The number of values pointed to must be at least the number of
+           inputs of the comparator network.
+      \param[in] first Iterator to the first value to sort.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+      \param[in] exchange The exchange policy (see Exchange.h), callable as
+                          exchange(first[i], first[j], doSwap) for any valid i
+                          and j, which must swap its first two arguments if and
+                          only if doSwap is true.
+    */
+    template <typename It,
+              typename Comp,
+              typename Exchange,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValues(It first, Comp comp, Exchange exchange) const {
         for (auto const & c : m_comparators) {
             auto & minValue = first[c.min()];
             auto & maxValue = first[c.max()];
-            if (comp(maxValue, minValue))
-                std::swap(minValue, maxValue);
+            exchange(minValue, maxValue, comp(maxValue, minValue));
+        }
+    }
+
+    /**
+      Applies this Stage to a batch of equal-length arrays stored in a
+      transposed (lane) layout, i.e. the j-th value of the i-th array is stored
+      at first[j * batchSize + i] (see toLaneLayout()). Each comparator is
+      applied to all arrays at once as a branch-free selection of the minimum
+      and maximum over the batchSize lanes of its two lines.
+
+      \pre The number of values pointed to must be at least the number of
+           inputs of the comparator network times batchSize.
+      \param[in] first Iterator to the first value of the batch.
+      \param[in] batchSize The number of arrays in the batch.
+    */
+    template <typename It,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValuesBatch(It first, std::size_t batchSize) const {
+        using D = typename std::iterator_traits<It>::difference_type;
+        for (auto const & c : m_comparators) {
+            auto const minLine(first + static_cast<D>(c.min() * batchSize));
+            auto const maxLine(first + static_cast<D>(c.max() * batchSize));
+            for (std::size_t i = 0u; i < batchSize; ++i) {
+                auto const minValue(minLine[static_cast<D>(i)]);
+                auto const maxValue(maxLine[static_cast<D>(i)]);
+                bool const doSwap = maxValue < minValue;
+                auto const newMinValue(doSwap ? maxValue : minValue);
+                auto const newMaxValue(doSwap ? minValue : maxValue);
+                minLine[static_cast<D>(i)] = newMinValue;
+                maxLine[static_cast<D>(i)] = newMaxValue;
+            }
+        }
+    }
+
+    /**
+      Applies this Stage to a batch of equal-length arrays stored in a
+      transposed (lane) layout, i.e. the j-th value of the i-th array is stored
+      at first[j * batchSize + i] (see toLaneLayout()).
+
+      \pre The number of values pointed to must be at least the number of
+           inputs of the comparator network times batchSize.
+      \param[in] first Iterator to the first value of the batch.
+      \param[in] batchSize The number of arrays in the batch.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+    */
+    template <typename It,
+              typename Comp,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValuesBatch(It first, std::size_t batchSize, Comp comp) const {
+        using D = typename std::iterator_traits<It>::difference_type;
+        for (auto const & c : m_comparators) {
+            auto const minLine(first + static_cast<D>(c.min() * batchSize));
+            auto const maxLine(first + static_cast<D>(c.max() * batchSize));
+            for (std::size_t i = 0u; i < batchSize; ++i) {
+                auto const minValue(minLine[static_cast<D>(i)]);
+                auto const maxValue(maxLine[static_cast<D>(i)]);
+                bool const doSwap = comp(maxValue, minValue);
+                auto const newMinValue(doSwap ? maxValue : minValue);
+                auto const newMaxValue(doSwap ? minValue : maxValue);
+                minLine[static_cast<D>(i)] = newMinValue;
+                maxLine[static_cast<D>(i)] = newMaxValue;
+            }
+        }
+    }
+
+    /**
+      Exports this stage as a pair of index arrays, i.e. writes the indexes of
+      the minimum lines of all comparators of this stage to one output range
+      and the indexes of the respective maximum lines to another. This is
+      suitable for gathering the lines before and scattering them after
+      performing all comparisons of this stage in bulk.
+      \param[in] minOut Iterator to the output range for minimum line indexes.
+      \param[in] maxOut Iterator to the output range for maximum line indexes.
+      \pre Both output ranges must have room for numComparators() elements.
+    */
+    template <typename MinOutIt, typename MaxOutIt>
+    void exportIndexes(MinOutIt minOut, MaxOutIt maxOut) const {
+        for (auto const & c : m_comparators) {
+            *minOut = c.min();
+            ++minOut;
+            *maxOut = c.max();
+            ++maxOut;
         }
     }
 
     /**
       Checks whether the given comparator can be added to this stage, i.e. if
-      neither line is used by another comparator.
+      neither line is used by another comparator. This takes constant time if
+      this stage has a line index (see buildLineIndex()), and time linear in
+      the number of comparators in this stage otherwise.
       \param[in] comparator A reference to the comparator.
       \returns The conflict type.
     */
-    ConflictType getConflictsWith(Comparator const & comparator);
+    ConflictType getConflictsWith(Comparator const & comparator)
+            const noexcept;
+
+    /**
+      Builds an index from lines to the comparators using them, which is
+      afterwards maintained by all methods modifying this stage and makes
+      getConflictsWith() run in constant time. The index takes memory linear
+      in the largest line index used by this stage, hence it should only be
+      kept for stages being actively built.
+      \throws std::bad_alloc an out-of-memory condition was encountered.
+    */
+    void buildLineIndex();
+
+    /** Releases the line index of this stage, if any. */
+    void clearLineIndex() noexcept;
+
+    /** \returns whether this stage has a line index. */
+    bool hasLineIndex() const noexcept { return m_hasLineIndex; }
 
     /** Inverts this stage by switching the direction of all its comparators. */
     void invert() noexcept;
@@ -180,11 +362,27 @@ public: /* Methods: */
 
     void swap(Stage & other) noexcept;
 
+private: /* Methods: */
+
+    void addToLineIndex(Comparator const & comparator) noexcept;
+
+    /** Rebuilds the line index, if any, or releases it on failure: */
+    void refreshLineIndex() noexcept;
+
 private: /* Fields: */
 
     /** Comparators contained in this stage: */
     Comparators m_comparators;
 
+    /**
+      If m_hasLineIndex, then for every line used by a comparator of this stage
+      m_lineIndex[line] == (((otherLine + 1) << 1) | isMin), where otherLine
+      is the other line of that comparator and isMin is 1 if line is the
+      minimum line of the comparator. All other elements are zero.
+    */
+    std::vector<std::size_t> m_lineIndex;
+    bool m_hasLineIndex = false;
+
 };
 
 bool operator<(Stage const & lhs, Stage const & rhs) noexcept;
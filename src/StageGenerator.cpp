@@ -0,0 +1,453 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#include "StageGenerator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <utility>
+#include <vector>
+
+
+namespace sharemind {
+namespace SortingNetwork {
+
+/*
+  The stage with a given index of a (sub)network is generated by recursing into
+  the subnetworks it consists of, which requires the depths of these. Since the
+  sizes of all subnetworks on the same level of the recursion differ by at most
+  one, there are only logarithmically many distinct sizes and their depths are
+  computed once and memoized.
+*/
+struct StageGenerator::Inner {
+
+/* Methods: */
+
+    Inner(Algorithm algorithm, std::size_t numInputs) {
+        switch (algorithm) {
+        case Algorithm::OddEvenMergeSort:
+            numStages = computeOddEvenSortDepth(numInputs);
+            break;
+        case Algorithm::BitonicMergeSort:
+            numStages = computeBitonicSortDepth(numInputs);
+            break;
+        case Algorithm::PairwiseSort:
+            numStages = computePairwiseSortDepth(numInputs);
+            break;
+        }
+    }
+
+    std::size_t sortDepth(std::size_t n) const noexcept {
+        if (n <= 2u)
+            return (n == 2u) ? 1u : 0u;
+        auto const it(sortDepths.find(n));
+        assert(it != sortDepths.end());
+        return it->second;
+    }
+
+    std::size_t mergerDepth(std::size_t a, std::size_t b) const noexcept {
+        auto const it(mergerDepths.find(std::make_pair(a, b)));
+        assert(it != mergerDepths.end());
+        return it->second;
+    }
+
+    /* Odd-even merge sort: */
+
+    std::size_t computeOddEvenSortDepth(std::size_t n) {
+        if (n <= 2u)
+            return sortDepth(n);
+        auto const it(sortDepths.find(n));
+        if (it != sortDepths.end())
+            return it->second;
+        auto const left = n / 2u;
+        auto const right = n - left;
+        auto const depth = std::max(computeOddEvenSortDepth(left),
+                                    computeOddEvenSortDepth(right))
+                           + computeOddEvenMergerDepth(left, right);
+        sortDepths.emplace(n, depth);
+        return depth;
+    }
+
+    std::size_t computeOddEvenMergerDepth(std::size_t left, std::size_t right) {
+        if (!left || !right)
+            return 0u;
+        if ((left == 1u) && (right == 1u))
+            return 1u;
+        auto const key(std::make_pair(left, right));
+        auto const it(mergerDepths.find(key));
+        if (it != mergerDepths.end())
+            return it->second;
+        // The final layer of comparators is never empty here:
+        auto const depth =
+                std::max(computeOddEvenMergerDepth(left - left / 2u,
+                                                   right - right / 2u),
+                         computeOddEvenMergerDepth(left / 2u, right / 2u))
+                + 1u;
+        mergerDepths.emplace(key, depth);
+        return depth;
+    }
+
+    std::size_t oddEvenMergerDepth(std::size_t left, std::size_t right)
+            const noexcept
+    {
+        if (!left || !right)
+            return 0u;
+        if ((left == 1u) && (right == 1u))
+            return 1u;
+        return mergerDepth(left, right);
+    }
+
+    void addOddEvenSortStage(Stage::Comparators & out,
+                             std::size_t n,
+                             std::size_t offset,
+                             std::size_t stage) const
+    {
+        if (stage >= sortDepth(n))
+            return;
+        if (n == 2u) {
+            out.emplace_back(offset, offset + 1u);
+            return;
+        }
+        auto const left = n / 2u;
+        auto const right = n - left;
+        auto const sortDepth_ = std::max(sortDepth(left), sortDepth(right));
+        if (stage < sortDepth_) {
+            addOddEvenSortStage(out, left, offset, stage);
+            addOddEvenSortStage(out, right, offset + left, stage);
+        } else {
+            addOddEvenMergerStage(out,
+                                  left,
+                                  offset,
+                                  1u,
+                                  right,
+                                  offset + left,
+                                  1u,
+                                  stage - sortDepth_);
+        }
+    }
+
+    void addOddEvenMergerStage(Stage::Comparators & out,
+                               std::size_t numLeftIndexes,
+                               std::size_t leftOffset,
+                               std::size_t leftSkip,
+                               std::size_t numRightIndexes,
+                               std::size_t rightOffset,
+                               std::size_t rightSkip,
+                               std::size_t stage) const
+    {
+        if (stage >= oddEvenMergerDepth(numLeftIndexes, numRightIndexes))
+            return;
+        if ((numLeftIndexes == 1u) && (numRightIndexes == 1u)) {
+            out.emplace_back(leftOffset, rightOffset);
+            return;
+        }
+        auto const numOddLeft = numLeftIndexes - numLeftIndexes / 2u;
+        auto const numOddRight = numRightIndexes - numRightIndexes / 2u;
+        auto const numEvenLeft = numLeftIndexes / 2u;
+        auto const numEvenRight = numRightIndexes / 2u;
+        auto const subDepth =
+                std::max(oddEvenMergerDepth(numOddLeft, numOddRight),
+                         oddEvenMergerDepth(numEvenLeft, numEvenRight));
+        if (stage < subDepth) {
+            addOddEvenMergerStage(out,
+                                  numOddLeft,
+                                  leftOffset,
+                                  leftSkip * 2u,
+                                  numOddRight,
+                                  rightOffset,
+                                  rightSkip * 2u,
+                                  stage);
+            addOddEvenMergerStage(out,
+                                  numEvenLeft,
+                                  leftOffset + leftSkip,
+                                  leftSkip * 2u,
+                                  numEvenRight,
+                                  rightOffset + rightSkip,
+                                  rightSkip * 2u,
+                                  stage);
+            return;
+        }
+
+        // The final layer, see Detail::emitOddEvenMerger():
+        auto maxIndex = numLeftIndexes + numRightIndexes;
+        maxIndex -= (maxIndex % 2u) ? 2u : 3u;
+        for (std::size_t i = 1u; i <= maxIndex; i += 2u)
+            out.emplace_back(
+                    (i < numLeftIndexes)
+                    ? (leftOffset + i * leftSkip)
+                    : (rightOffset + (i - numLeftIndexes) * rightSkip),
+                    ((i + 1u) < numLeftIndexes)
+                    ? (leftOffset + (i + 1u) * leftSkip)
+                    : (rightOffset + (i - numLeftIndexes + 1u) * rightSkip));
+    }
+
+    /* Bitonic merge sort: */
+
+    std::size_t computeBitonicSortDepth(std::size_t n) {
+        if (n <= 2u)
+            return sortDepth(n);
+        auto const it(sortDepths.find(n));
+        if (it != sortDepths.end())
+            return it->second;
+        auto const depth = std::max(computeBitonicSortDepth(n / 2u),
+                                    computeBitonicSortDepth(n - n / 2u))
+                           + computeBitonicMergerDepth(n);
+        sortDepths.emplace(n, depth);
+        return depth;
+    }
+
+    std::size_t computeBitonicMergerDepth(std::size_t n) {
+        if (n <= 2u)
+            return bitonicMergerDepth(n);
+        auto const key(std::make_pair(n, std::size_t(0u)));
+        auto const it(mergerDepths.find(key));
+        if (it != mergerDepths.end())
+            return it->second;
+        auto const depth = std::max(computeBitonicMergerDepth(n - n / 2u),
+                                    computeBitonicMergerDepth(n / 2u))
+                           + 1u;
+        mergerDepths.emplace(key, depth);
+        return depth;
+    }
+
+    std::size_t bitonicMergerDepth(std::size_t n) const noexcept {
+        if (n <= 2u)
+            return (n == 2u) ? 1u : 0u;
+        return mergerDepth(n, 0u);
+    }
+
+    static void addComparator(Stage::Comparators & out,
+                              std::size_t a,
+                              std::size_t b,
+                              bool inverted)
+    {
+        if (inverted) {
+            out.emplace_back(b, a);
+        } else {
+            out.emplace_back(a, b);
+        }
+    }
+
+    void addBitonicSortStage(Stage::Comparators & out,
+                             std::size_t n,
+                             std::size_t offset,
+                             bool inverted,
+                             std::size_t stage) const
+    {
+        if (stage >= sortDepth(n))
+            return;
+        if (n == 2u) {
+            addComparator(out, offset, offset + 1u, inverted);
+            return;
+        }
+        auto const left = n / 2u;
+        auto const sortDepth_ = std::max(sortDepth(left), sortDepth(n - left));
+        if (stage < sortDepth_) {
+            // The left half is inverted, see Detail::emitBitonicMergeSort():
+            addBitonicSortStage(out, left, offset, !inverted, stage);
+            addBitonicSortStage(out, n - left, offset + left, inverted, stage);
+        } else {
+            addBitonicMergerStage(out,
+                                  n,
+                                  offset,
+                                  1u,
+                                  inverted,
+                                  stage - sortDepth_);
+        }
+    }
+
+    void addBitonicMergerStage(Stage::Comparators & out,
+                               std::size_t n,
+                               std::size_t offset,
+                               std::size_t skip,
+                               bool inverted,
+                               std::size_t stage) const
+    {
+        if (stage >= bitonicMergerDepth(n))
+            return;
+        auto const subDepth =
+                (n > 2u)
+                ? std::max(bitonicMergerDepth(n - n / 2u),
+                           bitonicMergerDepth(n / 2u))
+                : 0u;
+        if (stage < subDepth) {
+            addBitonicMergerStage(out,
+                                  n - n / 2u,
+                                  offset,
+                                  2u * skip,
+                                  inverted,
+                                  stage);
+            addBitonicMergerStage(out,
+                                  n / 2u,
+                                  offset + skip,
+                                  2u * skip,
+                                  inverted,
+                                  stage);
+            return;
+        }
+        for (std::size_t i = 1u; i < n; i += 2u) {
+            auto const secondIndex = offset + (skip * i);
+            addComparator(out, secondIndex - skip, secondIndex, inverted);
+        }
+    }
+
+    /* Pairwise sort: */
+
+    /**
+      \returns the length of the m-th layer of the final comparators of the
+               pairwise sorting network, see Detail::emitPairwiseSort().
+    */
+    static std::size_t pairwiseLayerLength(std::size_t m) noexcept
+    { return (m % 2u) ? m : (m - 1u); }
+
+    static std::size_t numPairwiseLayers(std::size_t n) noexcept {
+        std::size_t r = 0u;
+        for (auto m = (n + 1u) / 2u; m > 1u; m = (m + 1u) / 2u)
+            if (1u + pairwiseLayerLength(m) < n)
+                ++r;
+        return r;
+    }
+
+    std::size_t computePairwiseSortDepth(std::size_t n) {
+        if (n <= 2u)
+            return sortDepth(n);
+        auto const it(sortDepths.find(n));
+        if (it != sortDepths.end())
+            return it->second;
+        auto const depth = 1u
+                           + std::max(computePairwiseSortDepth(n - n / 2u),
+                                      computePairwiseSortDepth(n / 2u))
+                           + numPairwiseLayers(n);
+        sortDepths.emplace(n, depth);
+        return depth;
+    }
+
+    void addPairwiseSortStage(Stage::Comparators & out,
+                              std::size_t n,
+                              std::size_t offset,
+                              std::size_t skip,
+                              std::size_t stage) const
+    {
+        if (stage >= sortDepth(n))
+            return;
+        if (stage == 0u) {
+            for (std::size_t i = 1u; i < n; i += 2u)
+                out.emplace_back(offset + (i - 1u) * skip, offset + i * skip);
+            return;
+        }
+        --stage;
+        auto const subDepth =
+                std::max(sortDepth(n - n / 2u), sortDepth(n / 2u));
+        if (stage < subDepth) {
+            addPairwiseSortStage(out, n - n / 2u, offset, skip * 2u, stage);
+            addPairwiseSortStage(out, n / 2u, offset + skip, skip * 2u, stage);
+            return;
+        }
+
+        // Find the non-empty layer with the remaining index:
+        stage -= subDepth;
+        for (auto m = (n + 1u) / 2u; m > 1u; m = (m + 1u) / 2u) {
+            auto const len = pairwiseLayerLength(m);
+            if (1u + len >= n)
+                continue;
+            if (stage == 0u) {
+                for (std::size_t i = 1u; i + len < n; i += 2u)
+                    out.emplace_back(offset + (i * skip),
+                                     offset + ((i + len) * skip));
+                return;
+            }
+            --stage;
+        }
+        assert(false);
+    }
+
+/* Fields: */
+
+    std::size_t numStages = 0u;
+
+    /* Depths of sorting networks by size, and of mergers by their sizes: */
+    std::map<std::size_t, std::size_t> sortDepths;
+    std::map<std::pair<std::size_t, std::size_t>, std::size_t> mergerDepths;
+
+};
+
+namespace {
+
+/** \returns the comparators of a stage sorted by their left lines. */
+Stage::Comparators sortedByLeft(Stage::Comparators comparators,
+                                std::size_t numLines)
+{
+    // The slots are only allocated if the stage is not sparse:
+    std::vector<std::size_t> slots;
+    Stage::Comparators buffer;
+    Detail::sortByLeft(comparators,
+                       buffer,
+                       numLines,
+                       [&slots, numLines](std::size_t line) -> std::size_t & {
+                           if (slots.empty())
+                               slots.assign(numLines, 0u);
+                           return slots[line];
+                       });
+    return comparators;
+}
+
+} // anonymous namespace
+
+StageGenerator::StageGenerator(Algorithm algorithm, std::size_t numInputs)
+    : m_algorithm(algorithm)
+    , m_numInputs(numInputs)
+    , m_inner(std::make_shared<Inner>(algorithm, numInputs))
+    , m_numStages(m_inner->numStages)
+{}
+
+StageGenerator::StageGenerator(StageGenerator &&) noexcept = default;
+StageGenerator::StageGenerator(StageGenerator const &) = default;
+
+StageGenerator & StageGenerator::operator=(StageGenerator &&) noexcept =
+        default;
+StageGenerator & StageGenerator::operator=(StageGenerator const &) = default;
+
+StageGenerator::~StageGenerator() noexcept = default;
+
+Stage StageGenerator::stage(std::size_t index) const {
+    assert(index < m_numStages);
+    Stage::Comparators comparators;
+    comparators.reserve(m_numInputs / 2u);
+    switch (m_algorithm) {
+    case Algorithm::OddEvenMergeSort:
+        m_inner->addOddEvenSortStage(comparators, m_numInputs, 0u, index);
+        break;
+    case Algorithm::BitonicMergeSort:
+        m_inner->addBitonicSortStage(comparators,
+                                     m_numInputs,
+                                     0u,
+                                     false,
+                                     index);
+        break;
+    case Algorithm::PairwiseSort:
+        m_inner->addPairwiseSortStage(comparators, m_numInputs, 0u, 1u, index);
+        break;
+    }
+    return Stage(sortedByLeft(std::move(comparators), m_numInputs));
+}
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
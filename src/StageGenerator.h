@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_STAGEGENERATOR_H
+#define SHAREMIND_LIBSORTNETWORK_STAGEGENERATOR_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <sharemind/Concepts.h>
+#include <sharemind/Iterator.h>
+#include <type_traits>
+#include "Algorithm.h"
+#include "Exchange.h"
+#include "Generators.h"
+#include "Stage.h"
+
+
+namespace sharemind {
+namespace SortingNetwork {
+
+/**
+  Generates the stages of a sorting network one at a time, without ever
+  materializing the whole network. Any stage can be generated in time and
+  memory linear in the number of inputs, straight from the recursion of the
+  respective algorithm, where the stages of independent subnetworks are merged
+  index by index.
+
+  The generated network applies the same comparators in the same order on
+  every line as the Network generated by the respective Network::make*()
+  function, except that it may apply a comparator twice in a row where the
+  Network applies it once. Hence applying either of them to the same values
+  yields the same result, and compressing the generated network yields the
+  Network. However, the Network moves every comparator to the earliest stage
+  possible, whereas here the stages of subnetworks of different depths are
+  only aligned at their beginnings. For numbers of inputs which are powers of
+  two both have the same number of stages, but otherwise Batcher's networks
+  generated here may have a few more stages (e.g. 8 more for 513 inputs).
+*/
+class StageGenerator {
+
+public: /* Types: */
+
+    /** An input iterator over the generated stages. */
+    class Iterator {
+
+    public: /* Types: */
+
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Stage;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Stage;
+
+    public: /* Methods: */
+
+        Iterator(StageGenerator const & generator, std::size_t index) noexcept
+            : m_generator(&generator)
+            , m_index(index)
+        {}
+
+        Stage operator*() const { return m_generator->stage(m_index); }
+
+        Iterator & operator++() noexcept {
+            ++m_index;
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept {
+            Iterator r(*this);
+            ++m_index;
+            return r;
+        }
+
+        bool operator==(Iterator const & rhs) const noexcept
+        { return m_index == rhs.m_index; }
+
+        bool operator!=(Iterator const & rhs) const noexcept
+        { return m_index != rhs.m_index; }
+
+    private: /* Fields: */
+
+        StageGenerator const * m_generator;
+        std::size_t m_index;
+
+    };
+
+public: /* Methods: */
+
+    /**
+      Prepares the generation of the stages of a sorting network.
+      \param[in] algorithm The algorithm of the sorting network.
+      \param[in] numInputs The number of inputs of the sorting network.
+    */
+    StageGenerator(Algorithm algorithm, std::size_t numInputs);
+
+    StageGenerator(StageGenerator &&) noexcept;
+    StageGenerator(StageGenerator const &);
+
+    StageGenerator & operator=(StageGenerator &&) noexcept;
+    StageGenerator & operator=(StageGenerator const &);
+
+    ~StageGenerator() noexcept;
+
+    Algorithm algorithm() const noexcept { return m_algorithm; }
+
+    std::size_t numInputs() const noexcept { return m_numInputs; }
+
+    std::size_t numStages() const noexcept { return m_numStages; }
+
+    /**
+      Generates a stage.
+      \param[in] index The index of the stage.
+      \returns the stage with the given index.
+    */
+    Stage stage(std::size_t index) const;
+
+    Iterator begin() const noexcept { return Iterator(*this, 0u); }
+    Iterator end() const noexcept { return Iterator(*this, m_numStages); }
+
+    /**
+      Applies the generated comparator network to a range of values. Instead of
+      stage by stage, the comparators are applied in the depth-first order of
+      the recursion of the algorithm. This requires no memory other than the
+      call stack and accesses the values in a cache friendly manner.
+
+      \pre The number of values pointed to must be at least numInputs().
+      \param[in] first Iterator to the first value to sort.
+    */
+    template <typename It,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type),
+                    Swappable(typename std::iterator_traits<It>::value_type))>
+    void sortValues(It first) const {
+        using T = typename std::iterator_traits<It>::value_type;
+        auto less = [](T const & a, T const & b) { return a < b; };
+        sortValues<It, decltype(less) &>(first, less, BranchingExchange());
+    }
+
+    /**
+      Applies the generated comparator network to a range of values, see
+      sortValues(first) for details.
+
+      \pre The number of values pointed to must be at least numInputs().
+      \param[in] first Iterator to the first value to sort.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+    */
+    template <typename It,
+              typename Comp,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    Swappable(typename std::iterator_traits<It>::value_type),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValues(It first, Comp comp) const
+    { sortValues<It, Comp &>(first, comp, BranchingExchange()); }
+
+    /**
+      Applies the generated comparator network to a range of values using the
+      given exchange policy and operator<() for comparisons, see
+      sortValues(first) for details.
+
+      \pre The number of values pointed to must be at least numInputs().
+      \param[in] first Iterator to the first value to sort.
+      \param[in] exchange The exchange policy (see Exchange.h), callable as
+                          exchange(first[i], first[j], doSwap) for any valid i
+                          and j, which must swap its first two arguments if and
+                          only if doSwap is true.
+    */
+    template <typename It,
+              typename Exchange,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type)),
+              typename std::enable_if<
+                    Detail::IsExchangePolicy<
+                            Exchange,
+                            typename std::iterator_traits<It>::value_type
+                    >::value,
+                    int>::type = 0>
+    void sortValues(It first, Exchange exchange) const {
+        using T = typename std::iterator_traits<It>::value_type;
+        auto less = [](T const & a, T const & b) { return a < b; };
+        sortValues<It, decltype(less) &, Exchange &>(first, less, exchange);
+    }
+
+    /**
+      Applies the generated comparator network to a range of values using the
+      given exchange policy, see sortValues(first) for details.
+
+      \pre The number of values pointed to must be at least numInputs().
+      \param[in] first Iterator to the first value to sort.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+      \param[in] exchange The exchange policy (see Exchange.h), callable as
+                          exchange(first[i], first[j], doSwap) for any valid i
+                          and j, which must swap its first two arguments if and
+                          only if doSwap is true.
+    */
+    template <typename It,
+              typename Comp,
+              typename Exchange,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    void sortValues(It first, Comp comp, Exchange exchange) const {
+        Detail::ValueApplier<It, Comp &, Exchange &> sorter{first,
+                                                           comp,
+                                                           exchange};
+        switch (m_algorithm) {
+        case Algorithm::OddEvenMergeSort:
+            Detail::emitOddEvenMergeSort(sorter, m_numInputs, 0u);
+            break;
+        case Algorithm::BitonicMergeSort:
+            Detail::emitBitonicMergeSort(sorter, m_numInputs, 0u, false);
+            break;
+        case Algorithm::PairwiseSort:
+            Detail::emitPairwiseSort(sorter, m_numInputs, 0u, 1u);
+            break;
+        }
+    }
+
+private: /* Types: */
+
+    struct Inner;
+
+private: /* Fields: */
+
+    Algorithm m_algorithm;
+    std::size_t m_numInputs;
+    std::shared_ptr<Inner const> m_inner;
+    std::size_t m_numStages;
+
+};
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_STAGEGENERATOR_H */
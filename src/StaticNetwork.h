@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2017-2018  Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Authors: Cybernetica AS <sharemind-support at cyber.ee>
+ */
+
+#ifndef SHAREMIND_LIBSORTNETWORK_STATICNETWORK_H
+#define SHAREMIND_LIBSORTNETWORK_STATICNETWORK_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <sharemind/Concepts.h>
+#include <sharemind/Iterator.h>
+#include <utility>
+#include "Algorithm.h"
+#include "Comparator.h"
+#include "Generators.h"
+#include "Network.h"
+#include "Stage.h"
+
+
+namespace sharemind {
+namespace SortingNetwork {
+namespace Detail {
+
+/**
+  Receives the comparators emitted by the generators in Generators.h in the
+  order in which the runtime generators of Network add them, and places each
+  comparator into the earliest stage following all stages of earlier
+  comparators on the same lines. Like Network::compress(), a comparator is
+  dropped if that stage already contains an identical comparator. Up to
+  Capacity comparators are stored along with their stage indexes.
+*/
+template <std::size_t NumInputs, std::size_t Capacity>
+class StaticNetworkBuilder {
+
+public: /* Methods: */
+
+    constexpr StaticNetworkBuilder() noexcept
+        : m_lastStages{}
+        , m_lastMins{}
+        , m_lastMaxs{}
+        , m_mins{}
+        , m_maxs{}
+        , m_stages{}
+    {}
+
+    constexpr void addComparator(std::size_t min, std::size_t max) noexcept {
+        auto const minStage = m_lastStages[min];
+        auto const maxStage = m_lastStages[max];
+        auto const prevStage = (minStage < maxStage) ? maxStage : minStage;
+        if (prevStage && (minStage == prevStage)
+            && (m_lastMins[min] == min) && (m_lastMaxs[min] == max))
+            return;
+        auto const stage = prevStage + 1u;
+        m_lastStages[min] = stage;
+        m_lastStages[max] = stage;
+        m_lastMins[min] = min;
+        m_lastMins[max] = min;
+        m_lastMaxs[min] = max;
+        m_lastMaxs[max] = max;
+        if (m_numComparators < Capacity) {
+            m_mins[m_numComparators] = min;
+            m_maxs[m_numComparators] = max;
+            m_stages[m_numComparators] = stage - 1u;
+        }
+        ++m_numComparators;
+        if (m_numStages < stage)
+            m_numStages = stage;
+    }
+
+    constexpr std::size_t numComparators() const noexcept
+    { return m_numComparators; }
+
+    constexpr std::size_t numStages() const noexcept { return m_numStages; }
+
+    constexpr std::size_t min(std::size_t i) const noexcept
+    { return m_mins[i]; }
+
+    constexpr std::size_t max(std::size_t i) const noexcept
+    { return m_maxs[i]; }
+
+    constexpr std::size_t stage(std::size_t i) const noexcept
+    { return m_stages[i]; }
+
+private: /* Fields: */
+
+    /* Per line, the 1-based index of and the comparator in its last stage: */
+    std::size_t m_lastStages[NumInputs ? NumInputs : 1u];
+    std::size_t m_lastMins[NumInputs ? NumInputs : 1u];
+    std::size_t m_lastMaxs[NumInputs ? NumInputs : 1u];
+
+    std::size_t m_mins[Capacity ? Capacity : 1u];
+    std::size_t m_maxs[Capacity ? Capacity : 1u];
+    std::size_t m_stages[Capacity ? Capacity : 1u];
+    std::size_t m_numComparators = 0u;
+    std::size_t m_numStages = 0u;
+
+};
+
+template <std::size_t NumInputs, Algorithm Alg, std::size_t Capacity>
+constexpr StaticNetworkBuilder<NumInputs, Capacity> buildStaticNetwork()
+        noexcept
+{
+    StaticNetworkBuilder<NumInputs, Capacity> builder;
+    switch (Alg) {
+    case Algorithm::OddEvenMergeSort:
+        emitOddEvenMergeSort(builder, NumInputs, 0u);
+        break;
+    case Algorithm::BitonicMergeSort:
+        emitBitonicMergeSort(builder, NumInputs, 0u, false);
+        break;
+    case Algorithm::PairwiseSort:
+        emitPairwiseSort(builder, NumInputs, 0u, 1u);
+        break;
+    }
+    return builder;
+}
+
+/**
+  The comparators of a static network, ordered by stage and within each stage
+  by their left lines, like in the stages of a Network.
+*/
+template <std::size_t NumComparators, std::size_t NumStages>
+struct StaticNetworkTable {
+    std::size_t mins[NumComparators ? NumComparators : 1u];
+    std::size_t maxs[NumComparators ? NumComparators : 1u];
+    std::size_t stageOffsets[NumStages + 1u];
+};
+
+template <std::size_t NumInputs,
+          Algorithm Alg,
+          std::size_t NumComparators,
+          std::size_t NumStages>
+constexpr StaticNetworkTable<NumComparators, NumStages> makeStaticNetworkTable()
+        noexcept
+{
+    auto const builder(
+                buildStaticNetwork<NumInputs, Alg, NumComparators>());
+    StaticNetworkTable<NumComparators, NumStages> r{{}, {}, {}};
+
+    // Counting sort by stage:
+    for (std::size_t i = 0u; i < NumComparators; ++i)
+        ++r.stageOffsets[builder.stage(i) + 1u];
+    for (std::size_t s = 0u; s < NumStages; ++s)
+        r.stageOffsets[s + 1u] += r.stageOffsets[s];
+    std::size_t next[NumStages ? NumStages : 1u] = {};
+    for (std::size_t i = 0u; i < NumComparators; ++i) {
+        auto const s = builder.stage(i);
+        auto const j = r.stageOffsets[s] + next[s]++;
+
+        // Insertion sort by the left line within the stage:
+        auto const min = builder.min(i);
+        auto const max = builder.max(i);
+        auto const left = (min < max) ? min : max;
+        auto k = j;
+        for (; k > r.stageOffsets[s]; --k) {
+            auto const prevMin = r.mins[k - 1u];
+            auto const prevMax = r.maxs[k - 1u];
+            if (((prevMin < prevMax) ? prevMin : prevMax) < left)
+                break;
+            r.mins[k] = prevMin;
+            r.maxs[k] = prevMax;
+        }
+        r.mins[k] = min;
+        r.maxs[k] = max;
+    }
+    return r;
+}
+
+} /* namespace Detail { */
+
+/**
+  A sorting network of a fixed size generated at compile time. It contains
+  exactly the same comparators in the same stages as the network generated at
+  runtime for NumInputs by the respective Network::make*() function, but its
+  comparators are stored in a constexpr table and sortValues() is fully
+  unrolled, i.e. it performs no loops and no heap allocations. This is intended
+  for small sizes (e.g. up to 64 inputs) where building a Network at runtime
+  would dominate the cost of sorting.
+*/
+template <std::size_t NumInputs, Algorithm Alg>
+class StaticNetwork {
+
+private: /* Constants: */
+
+    constexpr static Detail::StaticNetworkBuilder<NumInputs, 0u> const
+            m_counts = Detail::buildStaticNetwork<NumInputs, Alg, 0u>();
+
+public: /* Constants: */
+
+    constexpr static std::size_t const numInputs = NumInputs;
+    constexpr static Algorithm const algorithm = Alg;
+    constexpr static std::size_t const numComparators =
+            m_counts.numComparators();
+    constexpr static std::size_t const numStages = m_counts.numStages();
+
+private: /* Constants: */
+
+    constexpr static Detail::StaticNetworkTable<numComparators, numStages>
+            const m_table =
+                Detail::makeStaticNetworkTable<NumInputs,
+                                               Alg,
+                                               numComparators,
+                                               numStages>();
+
+public: /* Methods: */
+
+    /**
+      \param[in] index The index of the comparator over all stages.
+      \returns the comparator with the given index.
+    */
+    constexpr static Comparator comparator(std::size_t index) noexcept
+    { return Comparator(m_table.mins[index], m_table.maxs[index]); }
+
+    /**
+      \param[in] stageIndex The index of the stage, or numStages.
+      \returns the index of the first comparator of the given stage, or the
+               total number of comparators if stageIndex is numStages.
+    */
+    constexpr static std::size_t stageOffset(std::size_t stageIndex) noexcept
+    { return m_table.stageOffsets[stageIndex]; }
+
+    /** \returns a runtime Network with the comparators of this network. */
+    static Network makeNetwork() {
+        Network r(NumInputs);
+        for (std::size_t s = 0u; s < numStages; ++s) {
+            auto & stage = r.composeWithEmptyStage();
+            for (auto i = stageOffset(s); i < stageOffset(s + 1u); ++i)
+                stage.addComparator(comparator(i));
+        }
+        return r;
+    }
+
+    /**
+      Applies this network to a range of values.
+
+      \pre The number of values pointed to must be at least NumInputs.
+      \param[in] first Iterator to the first value to sort.
+    */
+    template <typename It,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    LessThanComparable(
+                            typename std::iterator_traits<It>::value_type),
+                    Swappable(typename std::iterator_traits<It>::value_type))>
+    static void sortValues(It first) {
+        using T = typename std::iterator_traits<It>::value_type;
+        auto comp = [](T const & a, T const & b) { return a < b; };
+        sortValues_(first, comp, std::make_index_sequence<numComparators>());
+    }
+
+    /**
+      Applies this network to a range of values.
+
+      \pre The number of values pointed to must be at least NumInputs.
+      \param[in] first Iterator to the first value to sort.
+      \param[in] comp The comparison function object which returns true if its
+                      first argument is less than (i.e. is ordered before) its
+                      second argument. The comparison function object must be
+                      callable as comp(first[i], first[j]) for any valid i and j
+                      and must not modify the objects passed to it.
+    */
+    template <typename It,
+              typename Comp,
+              SHAREMIND_REQUIRES_CONCEPTS(
+                    RandomAccessIterator(It),
+                    Swappable(typename std::iterator_traits<It>::value_type),
+                    BinaryPredicate(
+                            Comp,
+                            typename std::iterator_traits<It>::value_type,
+                            typename std::iterator_traits<It>::value_type))>
+    static void sortValues(It first, Comp comp)
+    { sortValues_(first, comp, std::make_index_sequence<numComparators>()); }
+
+private: /* Methods: */
+
+    template <typename T, typename Comp>
+    static void compareExchange(T & minValue, T & maxValue, Comp & comp) {
+        if (comp(maxValue, minValue))
+            std::swap(minValue, maxValue);
+    }
+
+    template <typename It, typename Comp, std::size_t ... Indexes>
+    static void sortValues_(It first,
+                            Comp & comp,
+                            std::index_sequence<Indexes...>)
+    {
+        using D = typename std::iterator_traits<It>::difference_type;
+        (void) first;
+        (void) comp;
+        // Braced initializer lists guarantee left-to-right evaluation:
+        (void) std::initializer_list<int>{
+            (compareExchange(first[static_cast<D>(m_table.mins[Indexes])],
+                             first[static_cast<D>(m_table.maxs[Indexes])],
+                             comp),
+             0)...};
+    }
+
+};
+
+template <std::size_t NumInputs, Algorithm Alg>
+constexpr Detail::StaticNetworkBuilder<NumInputs, 0u> const
+StaticNetwork<NumInputs, Alg>::m_counts;
+
+template <std::size_t NumInputs, Algorithm Alg>
+constexpr std::size_t const StaticNetwork<NumInputs, Alg>::numInputs;
+
+template <std::size_t NumInputs, Algorithm Alg>
+constexpr Algorithm const StaticNetwork<NumInputs, Alg>::algorithm;
+
+template <std::size_t NumInputs, Algorithm Alg>
+constexpr std::size_t const StaticNetwork<NumInputs, Alg>::numComparators;
+
+template <std::size_t NumInputs, Algorithm Alg>
+constexpr std::size_t const StaticNetwork<NumInputs, Alg>::numStages;
+
+template <std::size_t NumInputs, Algorithm Alg>
+constexpr Detail::StaticNetworkTable<
+            StaticNetwork<NumInputs, Alg>::numComparators,
+            StaticNetwork<NumInputs, Alg>::numStages> const
+StaticNetwork<NumInputs, Alg>::m_table;
+
+} /* namespace SortingNetwork { */
+} /* namespace sharemind { */
+
+#endif /* SHAREMIND_LIBSORTNETWORK_STATICNETWORK_H */
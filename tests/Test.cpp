@@ -17,13 +17,19 @@
  *
  */
 
+#include "../src/CompiledNetwork.h"
+#include "../src/Generators.h"
 #include "../src/Network.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <ios>
 #include <sharemind/TestAssert.h>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 
 #if 0
@@ -130,6 +136,66 @@ std::string serialize(sharemind::SortingNetwork::Network const & net) noexcept {
 
 constexpr std::size_t const sizeLimit = 12u;
 
+std::vector<std::size_t> makeTestValues(std::size_t size) {
+    std::vector<std::size_t> values(size);
+    for (std::size_t i = 0u; i < size; ++i)
+        values[i] = (i * 7u + 3u) % (size ? size : 1u);
+    std::reverse(values.begin(), values.end());
+    return values;
+}
+
+void testCompiled(sharemind::SortingNetwork::Network const & net) {
+    sharemind::SortingNetwork::CompiledNetwork const compiled(net);
+    SHAREMIND_TESTASSERT(compiled.numInputs() == net.numInputs());
+    SHAREMIND_TESTASSERT(compiled.numStages() == net.numStages());
+    SHAREMIND_TESTASSERT(compiled.numComparators() == net.numComparators());
+    for (std::size_t i = 0u; i < net.numStages(); ++i)
+        SHAREMIND_TESTASSERT(compiled.numComparators(i)
+                             == net.numComparators(i));
+
+    auto const values(makeTestValues(net.numInputs()));
+    auto expected(values);
+    net.sortValues(expected.data());
+    auto test(values);
+    compiled.sortValues(test.data());
+    SHAREMIND_TESTASSERT(test == expected);
+    test = values;
+    compiled.sortValues(test.data(), std::greater<std::size_t>());
+    expected = values;
+    net.sortValues(expected.data(), std::greater<std::size_t>());
+    SHAREMIND_TESTASSERT(test == expected);
+
+    // Gather, compare and scatter stage by stage using the index arrays:
+    auto const executeWith =
+            [&values](std::vector<std::size_t> & v) {
+                v = values;
+                using Index = sharemind::SortingNetwork::CompiledNetwork::Index;
+                return [&v](Index const * mins,
+                            Index const * maxs,
+                            std::size_t numComparators)
+                {
+                    std::vector<std::size_t> minValues(numComparators);
+                    std::vector<std::size_t> maxValues(numComparators);
+                    for (std::size_t i = 0u; i < numComparators; ++i) {
+                        minValues[i] = v[mins[i]];
+                        maxValues[i] = v[maxs[i]];
+                    }
+                    for (std::size_t i = 0u; i < numComparators; ++i) {
+                        if (maxValues[i] < minValues[i])
+                            std::swap(minValues[i], maxValues[i]);
+                        v[mins[i]] = minValues[i];
+                        v[maxs[i]] = maxValues[i];
+                    }
+                };
+            };
+    expected = values;
+    net.sortValues(expected.data());
+    net.executeStages(executeWith(test));
+    SHAREMIND_TESTASSERT(test == expected);
+    compiled.executeStages(executeWith(test));
+    SHAREMIND_TESTASSERT(test == expected);
+}
+
 template <typename NetworkGenerator>
 void testGenerator(NetworkGenerator && g, char const * const * const expected) {
     for (std::size_t size = 0u; size < sizeLimit; ++size) {
@@ -142,9 +208,48 @@ void testGenerator(NetworkGenerator && g, char const * const * const expected) {
         SHAREMIND_TESTASSERT(net.normalized().compressed()
                                     .bruteForceIsSortingNetwork());
         SHAREMIND_TESTASSERT(net.canonicalized().bruteForceIsSortingNetwork());
+        {
+            sharemind::SortingNetwork::Network composed(net.numInputs());
+            composed.composeWithStages(net.stages());
+            SHAREMIND_TESTASSERT(composed == net);
+            auto stages(net.stages());
+            composed.composeWithStages(std::move(stages));
+            SHAREMIND_TESTASSERT(composed.numStages() == 2u * net.numStages());
+        }
+        testCompiled(net);
     }
 }
 
+/** Collects the emitted comparators into stages of one comparator each: */
+struct UncompressedBuilder {
+    void addComparator(std::size_t min, std::size_t max) {
+        network.composeWithEmptyStage().addComparator(
+                    sharemind::SortingNetwork::Comparator(min, max));
+    }
+
+    sharemind::SortingNetwork::Network & network;
+};
+
+/**
+  Checks that the generated networks are the compressed networks emitted by the
+  recursive generators, also where the stages are computed in closed form.
+*/
+template <typename NetworkGenerator, typename Emit>
+void testCompressedEmitted(NetworkGenerator && g, Emit && emit) {
+    auto const test =
+            [&g, &emit](std::size_t size) {
+                sharemind::SortingNetwork::Network expected(size);
+                UncompressedBuilder builder{expected};
+                emit(builder, size);
+                expected.compress();
+                SHAREMIND_TESTASSERT(g(size) == expected);
+            };
+    for (std::size_t size = 0u; size <= 300u; ++size)
+        test(size);
+    for (std::size_t size = 512u; size <= 1024u; size *= 2u)
+        test(size);
+}
+
 } // anonymous namespace
 
 int main() {
@@ -155,4 +260,18 @@ int main() {
                   expectedOddEvenMergeSortNetworks);
     testGenerator(Network::makePairwiseSort,
                   expectedPairwiseSortNetworks);
+
+    namespace Detail = sharemind::SortingNetwork::Detail;
+    testCompressedEmitted(
+                Network::makeBitonicMergeSort,
+                [](UncompressedBuilder & b, std::size_t size)
+                { Detail::emitBitonicMergeSort(b, size, 0u, false); });
+    testCompressedEmitted(
+                Network::makeOddEvenMergeSort,
+                [](UncompressedBuilder & b, std::size_t size)
+                { Detail::emitOddEvenMergeSort(b, size, 0u); });
+    testCompressedEmitted(
+                Network::makePairwiseSort,
+                [](UncompressedBuilder & b, std::size_t size)
+                { Detail::emitPairwiseSort(b, size, 0u, 1u); });
 }
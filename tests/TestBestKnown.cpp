@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/Network.h"
+
+#include <cstddef>
+#include <sharemind/TestAssert.h>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::Objective;
+
+/* The sizes of the best known networks for up to 16 inputs and their depths: */
+constexpr std::size_t const bestKnownSizes[] = {
+    0u, 0u, 1u, 3u, 5u, 9u, 12u, 16u, 19u, 25u, 29u, 35u, 39u, 45u, 51u, 56u,
+    60u
+};
+constexpr std::size_t const sizeOptimalDepths[] = {
+    0u, 0u, 1u, 3u, 3u, 5u, 5u, 6u, 6u, 7u, 8u, 8u, 9u, 10u, 10u, 10u, 10u
+};
+
+/* The optimal depths for up to 16 inputs and the sizes of these networks: */
+constexpr std::size_t const optimalDepths[] = {
+    0u, 0u, 1u, 3u, 3u, 5u, 5u, 6u, 6u, 7u, 7u, 8u, 8u, 9u, 9u, 9u, 9u
+};
+constexpr std::size_t const depthOptimalSizes[] = {
+    0u, 0u, 1u, 3u, 5u, 9u, 12u, 16u, 19u, 25u, 31u, 35u, 40u, 47u, 52u, 57u,
+    61u
+};
+
+void testBestKnown() {
+    for (std::size_t n = 0u; n <= 40u; ++n) {
+        auto const oddEven(Network::makeOddEvenMergeSort(n));
+        auto const bitonic(Network::makeBitonicMergeSort(n));
+        auto const pairwise(Network::makePairwiseSort(n));
+        auto const bySize(Network::makeBestKnown(n));
+        auto const byDepth(Network::makeBestKnown(n, Objective::Depth));
+        SHAREMIND_TESTASSERT(bySize == Network::makeBestKnown(n,
+                                                              Objective::Size));
+        for (auto const * network : {&bySize, &byDepth}) {
+            SHAREMIND_TESTASSERT(network->numInputs() == n);
+            SHAREMIND_TESTASSERT(network->isSortingNetwork());
+        }
+        for (auto const * network : {&oddEven, &bitonic, &pairwise}) {
+            SHAREMIND_TESTASSERT(bySize.numComparators()
+                                 <= network->numComparators());
+            SHAREMIND_TESTASSERT(byDepth.numStages() <= network->numStages());
+        }
+        SHAREMIND_TESTASSERT(bySize.numComparators()
+                             <= byDepth.numComparators());
+        SHAREMIND_TESTASSERT(byDepth.numStages() <= bySize.numStages());
+        if (n <= 16u) {
+            SHAREMIND_TESTASSERT(bySize.numComparators() == bestKnownSizes[n]);
+            SHAREMIND_TESTASSERT(bySize.numStages() == sizeOptimalDepths[n]);
+            SHAREMIND_TESTASSERT(byDepth.numStages() == optimalDepths[n]);
+            SHAREMIND_TESTASSERT(byDepth.numComparators()
+                                 == depthOptimalSizes[n]);
+        } else if (n <= 32u) {
+            SHAREMIND_TESTASSERT(bySize.numComparators()
+                                 < oddEven.numComparators());
+        }
+    }
+    SHAREMIND_TESTASSERT(Network::makeBestKnown(32u).numComparators() == 185u);
+    SHAREMIND_TESTASSERT(
+            Network::makeBestKnown(32u, Objective::Depth).numStages() == 14u);
+}
+
+void testDivideAndConquer() {
+    for (std::size_t n = 0u; n <= 40u; ++n) {
+        for (std::size_t leafSize : {0u, 1u, 2u, 5u, 16u, 32u, 100u}) {
+            for (auto objective : {Objective::Size, Objective::Depth}) {
+                auto const network(
+                        Network::makeSortWithDivideAndConquer(n,
+                                                              leafSize,
+                                                              objective));
+                SHAREMIND_TESTASSERT(network.numInputs() == n);
+                SHAREMIND_TESTASSERT(network.isSortingNetwork());
+            }
+        }
+    }
+
+    // With trivial leaves, this is Batcher's Odd-Even-Mergesort:
+    for (std::size_t n : {7u, 16u, 100u})
+        SHAREMIND_TESTASSERT(Network::makeSortWithDivideAndConquer(n, 1u)
+                             == Network::makeOddEvenMergeSort(n));
+
+    for (std::size_t n : {64u, 100u, 1000u, 4096u}) {
+        auto const oddEven(Network::makeOddEvenMergeSort(n));
+        auto const network(Network::makeSortWithDivideAndConquer(n));
+        SHAREMIND_TESTASSERT(network.numComparators()
+                             < oddEven.numComparators());
+        SHAREMIND_TESTASSERT(network.numStages() <= oddEven.numStages());
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    testBestKnown();
+    testDivideAndConquer();
+}
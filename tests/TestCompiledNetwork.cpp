@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/CompiledNetwork.h"
+#include "../src/LaneLayout.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::CompiledNetwork;
+using sharemind::SortingNetwork::Detail::KernelIsa;
+using sharemind::SortingNetwork::Detail::setMaxKernelIsa;
+using sharemind::SortingNetwork::Detail::supportedKernelIsa;
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::fromLaneLayout;
+using sharemind::SortingNetwork::toLaneLayout;
+
+template <typename T>
+std::vector<T> makeRandomValues(std::size_t size, std::mt19937_64 & rng) {
+    std::vector<T> values(size);
+    for (auto & value : values) {
+        auto const bits = rng();
+        std::memcpy(&value, &bits, sizeof(T));
+    }
+    return values;
+}
+
+template <typename T>
+void fixFloatingPoint(std::vector<T> & values, std::mt19937_64 & rng) {
+    for (auto & value : values) {
+        switch (rng() % 8u) {
+        case 0u: value = std::numeric_limits<T>::quiet_NaN(); break;
+        case 1u: value = static_cast<T>(-0.0); break;
+        case 2u: value = static_cast<T>(0.0); break;
+        case 3u: value = std::numeric_limits<T>::infinity(); break;
+        default: value = static_cast<T>(static_cast<std::int64_t>(rng() % 1000u)
+                                        - 500);
+        }
+    }
+}
+
+void fixFloatingPoint(std::vector<std::int32_t> &, std::mt19937_64 &) {}
+void fixFloatingPoint(std::vector<std::uint32_t> &, std::mt19937_64 &) {}
+void fixFloatingPoint(std::vector<std::int64_t> &, std::mt19937_64 &) {}
+void fixFloatingPoint(std::vector<std::uint64_t> &, std::mt19937_64 &) {}
+
+template <typename T>
+void testKernel(Network const & net,
+                CompiledNetwork const & compiled,
+                std::mt19937_64 & rng)
+{
+    for (unsigned round = 0u; round < 4u; ++round) {
+        auto values(makeRandomValues<T>(net.numInputs(), rng));
+        fixFloatingPoint(values, rng);
+        auto expected(values);
+        net.sortValues(expected.data());
+        auto test(values);
+        compiled.sortValues(test.data()); // Uses the dispatched kernels
+        SHAREMIND_TESTASSERT(std::memcmp(test.data(),
+                                         expected.data(),
+                                         sizeof(T) * test.size()) == 0);
+    }
+}
+
+template <typename T>
+void testBatch(Network const & net,
+               CompiledNetwork const & compiled,
+               std::size_t batchSize,
+               std::mt19937_64 & rng)
+{
+    auto const size = net.numInputs();
+    auto values(makeRandomValues<T>(size * batchSize, rng));
+    fixFloatingPoint(values, rng);
+
+    auto expected(values);
+    for (std::size_t i = 0u; i < batchSize; ++i)
+        net.sortValues(expected.data() + i * size);
+    auto expectedDescending(values);
+    for (std::size_t i = 0u; i < batchSize; ++i)
+        net.sortValues(expectedDescending.data() + i * size, std::greater<T>());
+
+    std::vector<T> lanes(values.size());
+    toLaneLayout(values.data(), batchSize, size, lanes.data());
+    std::vector<T> test(values.size());
+    fromLaneLayout(lanes.data(), batchSize, size, test.begin());
+    SHAREMIND_TESTASSERT(std::memcmp(test.data(),
+                                     values.data(),
+                                     sizeof(T) * test.size()) == 0);
+
+    auto const check =
+            [&](std::vector<T> const & l, std::vector<T> const & e) {
+                fromLaneLayout(l.begin(), batchSize, size, test.data());
+                SHAREMIND_TESTASSERT(std::memcmp(test.data(),
+                                                 e.data(),
+                                                 sizeof(T) * e.size()) == 0);
+            };
+    auto l(lanes);
+    net.sortValuesBatch(l.data(), batchSize);
+    check(l, expected);
+    l = lanes;
+    compiled.sortValuesBatch(l.begin(), batchSize);
+    check(l, expected);
+    l = lanes;
+    net.sortValuesBatch(l.data(), batchSize, std::greater<T>());
+    check(l, expectedDescending);
+    l = lanes;
+    compiled.sortValuesBatch(l.data(), batchSize, std::greater<T>());
+    check(l, expectedDescending);
+}
+
+void testNetworks(std::mt19937_64 & rng) {
+    for (std::size_t size : {2u, 7u, 16u, 33u, 64u, 100u, 257u, 1024u}) {
+        for (auto const & net : {Network::makeOddEvenMergeSort(size),
+                                 Network::makeBitonicMergeSort(size),
+                                 Network::makePairwiseSort(size)})
+        {
+            CompiledNetwork const compiled(net);
+            testKernel<std::int32_t>(net, compiled, rng);
+            testKernel<std::uint32_t>(net, compiled, rng);
+            testKernel<std::int64_t>(net, compiled, rng);
+            testKernel<std::uint64_t>(net, compiled, rng);
+            testKernel<float>(net, compiled, rng);
+            testKernel<double>(net, compiled, rng);
+            for (std::size_t batchSize : {1u, 5u, 33u}) {
+                testBatch<std::int32_t>(net, compiled, batchSize, rng);
+                testBatch<std::uint64_t>(net, compiled, batchSize, rng);
+                testBatch<double>(net, compiled, batchSize, rng);
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    std::mt19937_64 rng(42u);
+    // Test the kernels of every instruction set supported by the CPU:
+    auto const supported = supportedKernelIsa();
+    for (auto const isa : {KernelIsa::Generic,
+                           KernelIsa::Avx2,
+                           KernelIsa::Avx512})
+    {
+        if (isa > supported)
+            break;
+        setMaxKernelIsa(isa);
+        testNetworks(rng);
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/Network.h"
+
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <sharemind/TestAssert.h>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Comparator;
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::Stage;
+
+/**
+  The reference implementation of Network::compress() which moves every
+  comparator back one stage at a time:
+*/
+Network referenceCompressed(Network const & network) {
+    auto stages(network.stages());
+    if (stages.empty())
+        return network;
+    for (auto stageIt = std::next(stages.begin()); stageIt != stages.end();
+         ++stageIt)
+    {
+        auto comps(stageIt->comparators());
+        for (std::size_t i = 0u; i < comps.size(); ++i) {
+            auto targetStageIt(stageIt);
+            for (auto prevStageIt = std::prev(stageIt);; --prevStageIt) {
+                auto const conflict = prevStageIt->getConflictsWith(comps[i]);
+                if (conflict == Stage::NoConflict) {
+                    targetStageIt = prevStageIt;
+                } else {
+                    if (conflict == Stage::ComparatorAlreadyPresent)
+                        targetStageIt = stages.end();
+                    break;
+                }
+                if (prevStageIt == stages.begin())
+                    break;
+            }
+            if (targetStageIt != stageIt) {
+                if (targetStageIt != stages.end())
+                    targetStageIt->addComparator(comps[i]);
+                for (std::size_t j = 0u; j < stageIt->numComparators(); ++j) {
+                    auto const & c = stageIt->comparators()[j];
+                    if ((c.min() == comps[i].min())
+                        && (c.max() == comps[i].max()))
+                    {
+                        stageIt->removeComparator(j);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    Network r(network.numInputs());
+    for (auto & stage : stages)
+        if (!stage.empty())
+            r.composeWith(std::move(stage));
+    return r;
+}
+
+} // anonymous namespace
+
+int main() {
+    std::mt19937_64 rng(42u);
+    for (unsigned round = 0u; round < 500u; ++round) {
+        std::size_t const numInputs = 2u + rng() % 12u;
+        Network net(numInputs);
+        auto const numStages = rng() % 20u;
+        for (std::size_t s = 0u; s < numStages; ++s) {
+            Stage & stage = net.composeWithEmptyStage();
+            auto const tries = rng() % (numInputs + 1u);
+            for (std::size_t i = 0u; i < tries; ++i) {
+                Comparator const c(rng() % numInputs, rng() % numInputs);
+                if ((c.min() != c.max())
+                    && (stage.getConflictsWith(c) == Stage::NoConflict))
+                    stage.addComparator(c);
+            }
+            /* Repeat some stages to exercise the removal of duplicates: */
+            if ((rng() % 4u) == 0u)
+                net.composeWith(Stage(stage));
+        }
+        auto const expected(referenceCompressed(net));
+        net.compress();
+        SHAREMIND_TESTASSERT(net == expected);
+        SHAREMIND_TESTASSERT(net.compressed() == net);
+    }
+
+    for (std::size_t n : {0u, 1u, 2u, 7u, 16u, 33u, 100u}) {
+        for (auto const & net : {Network::makeOddEvenMergeSort(n),
+                                 Network::makeBitonicMergeSort(n),
+                                 Network::makePairwiseSort(n)})
+        {
+            SHAREMIND_TESTASSERT(net.compressed() == net);
+            SHAREMIND_TESTASSERT(net.compressed()
+                                 == referenceCompressed(net));
+        }
+    }
+}
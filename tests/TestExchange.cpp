@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/CompiledNetwork.h"
+#include "../src/Exchange.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::BranchFreeExchange;
+using sharemind::SortingNetwork::BranchingExchange;
+using sharemind::SortingNetwork::CompiledNetwork;
+using sharemind::SortingNetwork::Network;
+
+struct Record {
+    std::uint32_t key;
+    std::uint16_t a;
+    unsigned char b;
+};
+
+/** A 15-byte record to exercise all chunk sizes of BranchFreeExchange: */
+struct OddRecord { unsigned char bytes[15u]; };
+
+template <typename T>
+void testSwap(T const & x, T const & y) {
+    T a(x);
+    T b(y);
+    BranchFreeExchange()(a, b, false);
+    SHAREMIND_TESTASSERT(std::memcmp(&a, &x, sizeof(T)) == 0);
+    SHAREMIND_TESTASSERT(std::memcmp(&b, &y, sizeof(T)) == 0);
+    BranchFreeExchange()(a, b, true);
+    SHAREMIND_TESTASSERT(std::memcmp(&a, &y, sizeof(T)) == 0);
+    SHAREMIND_TESTASSERT(std::memcmp(&b, &x, sizeof(T)) == 0);
+}
+
+/** A user-provided exchange policy which counts the exchanges: */
+struct CountingExchange {
+    template <typename T>
+    void operator()(T & minValue, T & maxValue, bool doSwap) {
+        ++m_numExchanges;
+        BranchFreeExchange()(minValue, maxValue, doSwap);
+    }
+    std::size_t m_numExchanges = 0u;
+};
+
+void testNetwork(Network const & net, std::mt19937_64 & rng) {
+    CompiledNetwork const compiled(net);
+    std::vector<Record> values(net.numInputs());
+    for (auto & value : values) {
+        value.key = static_cast<std::uint32_t>(rng() % 100u);
+        value.a = static_cast<std::uint16_t>(rng());
+        value.b = static_cast<unsigned char>(rng());
+    }
+    auto const less =
+            [](Record const & x, Record const & y) { return x.key < y.key; };
+
+    auto expected(values);
+    net.sortValues(expected.data(), less);
+    auto const check = [&expected](std::vector<Record> const & test) {
+        for (std::size_t i = 0u; i < test.size(); ++i) {
+            SHAREMIND_TESTASSERT(test[i].key == expected[i].key);
+            SHAREMIND_TESTASSERT(test[i].a == expected[i].a);
+            SHAREMIND_TESTASSERT(test[i].b == expected[i].b);
+        }
+    };
+
+    auto test(values);
+    net.sortValues(test.data(), less, BranchingExchange());
+    check(test);
+    test = values;
+    net.sortValues(test.begin(), less, BranchFreeExchange());
+    check(test);
+    test = values;
+    compiled.sortValues(test.data(), less, BranchFreeExchange());
+    check(test);
+    test = values;
+    CountingExchange counter;
+    net.sortValues(test.data(), less, std::ref(counter));
+    check(test);
+    SHAREMIND_TESTASSERT(counter.m_numExchanges == net.numComparators());
+
+    std::vector<double> doubles(net.numInputs());
+    for (auto & value : doubles)
+        value = static_cast<double>(rng() % 1000u) - 500.0;
+    auto expectedDoubles(doubles);
+    net.sortValues(expectedDoubles.data(), std::greater<double>());
+    net.sortValues(doubles.data(),
+                   std::greater<double>(),
+                   BranchFreeExchange());
+    SHAREMIND_TESTASSERT(doubles == expectedDoubles);
+
+    net.sortValues(expectedDoubles.data());
+    doubles = expectedDoubles;
+    std::reverse(doubles.begin(), doubles.end());
+    net.sortValues(doubles.data(), BranchFreeExchange());
+    SHAREMIND_TESTASSERT(doubles == expectedDoubles);
+    std::reverse(doubles.begin(), doubles.end());
+    compiled.sortValues(doubles.data(), BranchFreeExchange());
+    SHAREMIND_TESTASSERT(doubles == expectedDoubles);
+}
+
+} // anonymous namespace
+
+int main() {
+    testSwap<bool>(false, true);
+    testSwap<std::int8_t>(-3, 100);
+    testSwap<std::int32_t>(-3, 100);
+    testSwap<std::uint64_t>(0xffffffffffffffffu, 42u);
+    testSwap<float>(-1.5f, 3.0f);
+    testSwap<double>(-1.5, 3.0);
+    {
+        OddRecord x;
+        OddRecord y;
+        for (unsigned i = 0u; i < sizeof(x.bytes); ++i) {
+            x.bytes[i] = static_cast<unsigned char>(i);
+            y.bytes[i] = static_cast<unsigned char>(255u - i);
+        }
+        testSwap(x, y);
+    }
+
+    std::mt19937_64 rng(42u);
+    for (std::size_t size : {0u, 1u, 2u, 7u, 16u, 33u, 100u})
+        for (auto const & net : {Network::makeOddEvenMergeSort(size),
+                                 Network::makeBitonicMergeSort(size),
+                                 Network::makePairwiseSort(size)})
+            testNetwork(net, rng);
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/Merge.h"
+#include "../src/Network.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::BranchFreeExchange;
+using sharemind::SortingNetwork::Network;
+
+std::size_t log2Ceil(std::size_t n) {
+    std::size_t r = 0u;
+    while ((std::size_t(1u) << r) < n)
+        ++r;
+    return r;
+}
+
+void testMergers() {
+    for (std::size_t n0 = 0u; n0 <= 40u; ++n0) {
+        for (std::size_t n1 = 0u; n1 <= 40u; ++n1) {
+            auto const merger(Network::makeOddEvenMerger(n0, n1));
+            SHAREMIND_TESTASSERT(merger.numInputs() == n0 + n1);
+            SHAREMIND_TESTASSERT(
+                    merger == combineOddEvenMerge(Network(n0), Network(n1)));
+            SHAREMIND_TESTASSERT(isMergingNetwork(merger, n0, n1));
+        }
+    }
+    for (std::size_t n = 0u; n <= 80u; ++n) {
+        auto const merger(Network::makeBitonicMerger(n));
+        SHAREMIND_TESTASSERT(merger.numInputs() == n);
+        SHAREMIND_TESTASSERT(isMergingNetwork(merger, n / 2u, n - n / 2u));
+        SHAREMIND_TESTASSERT(merger.numStages() <= log2Ceil(n));
+    }
+    for (std::size_t n : {1000u, 1024u, 1025u}) {
+        SHAREMIND_TESTASSERT(
+                isMergingNetwork(Network::makeBitonicMerger(n),
+                                 n / 2u,
+                                 n - n / 2u));
+        auto const merger(Network::makeOddEvenMerger(n, 700u));
+        SHAREMIND_TESTASSERT(merger.numStages() <= log2Ceil(n) + 1u);
+        SHAREMIND_TESTASSERT(isMergingNetwork(merger, n, 700u));
+    }
+}
+
+void testMergeValues(std::mt19937_64 & rng) {
+    std::vector<int> values;
+    std::vector<int> expected;
+    for (std::size_t n0 = 0u; n0 <= 70u; n0 += 7u) {
+        for (std::size_t n1 = 0u; n1 <= 70u; n1 += 5u) {
+            values.resize(n0 + n1);
+            for (auto & value : values)
+                value = static_cast<int>(rng() % 50u);
+            auto const middle = values.begin() + static_cast<long>(n0);
+            std::sort(values.begin(), middle);
+            std::sort(middle, values.end());
+            expected = values;
+            std::sort(expected.begin(), expected.end());
+
+            auto merged(values);
+            sharemind::SortingNetwork::mergeValues(merged.begin(), n0, n1);
+            SHAREMIND_TESTASSERT(merged == expected);
+
+            merged = values;
+            auto const mergedMiddle = merged.begin() + static_cast<long>(n0);
+            std::reverse(merged.begin(), mergedMiddle);
+            std::reverse(mergedMiddle, merged.end());
+            sharemind::SortingNetwork::mergeValues(merged.data(),
+                                                   n0,
+                                                   n1,
+                                                   std::greater<int>());
+            std::reverse(merged.begin(), merged.end());
+            SHAREMIND_TESTASSERT(merged == expected);
+
+            merged = values;
+            sharemind::SortingNetwork::mergeValues(merged.data(),
+                                                   n0,
+                                                   n1,
+                                                   std::less<int>(),
+                                                   BranchFreeExchange());
+            SHAREMIND_TESTASSERT(merged == expected);
+
+            merged = values;
+            sharemind::SortingNetwork::mergeValues(merged.data(),
+                                                   n0,
+                                                   n1,
+                                                   BranchFreeExchange());
+            SHAREMIND_TESTASSERT(merged == expected);
+        }
+    }
+
+    // Appending sorted batches to a large sorted buffer:
+    std::vector<unsigned> buffer;
+    for (std::size_t batch = 0u; batch < 20u; ++batch) {
+        auto const oldSize = buffer.size();
+        auto const batchSize = static_cast<std::size_t>(rng() % 1000u);
+        for (std::size_t i = 0u; i < batchSize; ++i)
+            buffer.emplace_back(static_cast<unsigned>(rng()));
+        std::sort(buffer.begin() + static_cast<long>(oldSize), buffer.end());
+        sharemind::SortingNetwork::mergeValues(buffer.begin(),
+                                               oldSize,
+                                               batchSize);
+        SHAREMIND_TESTASSERT(std::is_sorted(buffer.begin(), buffer.end()));
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    std::mt19937_64 rng(42u);
+    testMergers();
+    testMergeValues(rng);
+}
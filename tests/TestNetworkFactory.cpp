@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/NetworkFactory.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Algorithm;
+using sharemind::SortingNetwork::CompiledNetwork;
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::NetworkFactory;
+
+bool equal(CompiledNetwork const & a, CompiledNetwork const & b) {
+    if ((a.numInputs() != b.numInputs())
+        || (a.numStages() != b.numStages())
+        || (a.numComparators() != b.numComparators()))
+        return false;
+    auto const size = a.numStages() + 1u + 2u * a.numComparators();
+    return std::equal(a.stageOffsets(),
+                      a.stageOffsets() + size,
+                      b.stageOffsets());
+}
+
+void testContents() {
+    NetworkFactory factory;
+    for (std::size_t n = 0u; n <= 40u; ++n) {
+        auto const oddEven(factory.network(Algorithm::OddEvenMergeSort, n));
+        SHAREMIND_TESTASSERT(*oddEven == Network::makeOddEvenMergeSort(n));
+        SHAREMIND_TESTASSERT(
+                factory.network(Algorithm::OddEvenMergeSort, n) == oddEven);
+        SHAREMIND_TESTASSERT(*factory.network(Algorithm::PairwiseSort, n)
+                             == Network::makePairwiseSort(n));
+
+        auto expected(Network::makeBitonicMergeSort(n));
+        SHAREMIND_TESTASSERT(*factory.network(Algorithm::BitonicMergeSort, n)
+                             == expected);
+        expected.normalize();
+        auto const normalized(factory.network(Algorithm::BitonicMergeSort,
+                                              n,
+                                              NetworkFactory::Normalize));
+        SHAREMIND_TESTASSERT(*normalized == expected);
+        expected.canonicalize();
+        SHAREMIND_TESTASSERT(
+                *factory.network(Algorithm::BitonicMergeSort,
+                                 n,
+                                 NetworkFactory::Normalize
+                                 | NetworkFactory::Canonicalize)
+                == expected);
+
+        auto const compiled(
+                factory.compiledNetwork(Algorithm::BitonicMergeSort,
+                                        n,
+                                        NetworkFactory::Normalize));
+        SHAREMIND_TESTASSERT(equal(*compiled, CompiledNetwork(*normalized)));
+        SHAREMIND_TESTASSERT(
+                factory.compiledNetwork(Algorithm::BitonicMergeSort,
+                                        n,
+                                        NetworkFactory::Normalize)
+                == compiled);
+    }
+    SHAREMIND_TESTASSERT(factory.size() == 41u * 6u);
+    SHAREMIND_TESTASSERT(factory.memoryUsage() > 0u);
+    factory.clear();
+    SHAREMIND_TESTASSERT(factory.size() == 0u);
+    SHAREMIND_TESTASSERT(factory.memoryUsage() == 0u);
+    SHAREMIND_TESTASSERT(&NetworkFactory::instance()
+                         == &NetworkFactory::instance());
+}
+
+void testMemoryLimit() {
+    NetworkFactory factory;
+    auto const first(factory.network(Algorithm::OddEvenMergeSort, 256u));
+    auto const firstUsage = factory.memoryUsage();
+    SHAREMIND_TESTASSERT(firstUsage > 0u);
+
+    factory.setMemoryLimit(firstUsage * 3u);
+    SHAREMIND_TESTASSERT(factory.memoryLimit() == firstUsage * 3u);
+    factory.network(Algorithm::OddEvenMergeSort, 255u);
+    factory.network(Algorithm::OddEvenMergeSort, 254u);
+    // Uses the first network, so the one with 255 inputs is evicted next:
+    SHAREMIND_TESTASSERT(
+            factory.network(Algorithm::OddEvenMergeSort, 256u) == first);
+    factory.network(Algorithm::OddEvenMergeSort, 253u);
+    SHAREMIND_TESTASSERT(factory.memoryUsage() <= firstUsage * 3u);
+    SHAREMIND_TESTASSERT(factory.size() == 3u);
+    SHAREMIND_TESTASSERT(
+            factory.network(Algorithm::OddEvenMergeSort, 256u) == first);
+
+    // Evicted networks remain valid and are regenerated on demand:
+    factory.setMemoryLimit(1u);
+    SHAREMIND_TESTASSERT(factory.size() == 0u);
+    SHAREMIND_TESTASSERT(factory.memoryUsage() == 0u);
+    SHAREMIND_TESTASSERT(*first == Network::makeOddEvenMergeSort(256u));
+    auto const second(factory.network(Algorithm::OddEvenMergeSort, 256u));
+    SHAREMIND_TESTASSERT(second != first);
+    SHAREMIND_TESTASSERT(*second == *first);
+    SHAREMIND_TESTASSERT(factory.size() == 0u);
+
+    factory.setMemoryLimit(0u);
+    factory.network(Algorithm::OddEvenMergeSort, 256u);
+    SHAREMIND_TESTASSERT(factory.size() == 1u);
+}
+
+void testConcurrency() {
+    constexpr std::size_t const numThreads = 8u;
+    constexpr std::size_t const numSizes = 40u;
+    constexpr std::size_t const numRequests = 400u;
+    NetworkFactory factory;
+    std::vector<std::vector<std::shared_ptr<CompiledNetwork const> > >
+            results(numThreads);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0u; t < numThreads; ++t) {
+        threads.emplace_back(
+            [&factory, &results, t]() {
+                std::mt19937_64 rng(t);
+                auto & r = results[t];
+                r.resize(numSizes);
+                for (std::size_t i = 0u; i < numRequests; ++i) {
+                    auto const n = static_cast<std::size_t>(rng() % numSizes);
+                    auto compiled(
+                            factory.compiledNetwork(Algorithm::PairwiseSort,
+                                                    n * 7u));
+                    if (r[n]) {
+                        SHAREMIND_TESTASSERT(compiled == r[n]);
+                    } else {
+                        r[n] = std::move(compiled);
+                    }
+                }
+            });
+    }
+    for (auto & thread : threads)
+        thread.join();
+    for (std::size_t n = 0u; n < numSizes; ++n) {
+        std::shared_ptr<CompiledNetwork const> expected;
+        for (auto const & r : results) {
+            if (!r[n])
+                continue;
+            if (expected) {
+                SHAREMIND_TESTASSERT(r[n] == expected);
+            } else {
+                expected = r[n];
+                SHAREMIND_TESTASSERT(
+                        equal(*expected,
+                              CompiledNetwork(
+                                  Network::makePairwiseSort(n * 7u))));
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    testContents();
+    testMemoryLimit();
+    testConcurrency();
+}
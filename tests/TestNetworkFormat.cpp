@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/NetworkFormat.h"
+#include "../src/NetworkView.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Comparator;
+using sharemind::SortingNetwork::InvalidNetworkFormat;
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::NetworkView;
+
+std::string const path("TestNetworkFormat.network");
+
+std::string save(Network const & network) {
+    std::ostringstream oss;
+    network.save(oss);
+    SHAREMIND_TESTASSERT(oss.good());
+    return oss.str();
+}
+
+Network load(std::string const & data) {
+    std::istringstream iss(data);
+    return Network::load(iss);
+}
+
+void writeFile(std::string const & data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    SHAREMIND_TESTASSERT(out.good());
+}
+
+template <typename F>
+bool throwsInvalidFormat(F && f) {
+    try {
+        f();
+    } catch (InvalidNetworkFormat const &) {
+        return true;
+    }
+    return false;
+}
+
+void testRoundTrip(Network const & network, std::mt19937_64 & rng) {
+    auto const data(save(network));
+    SHAREMIND_TESTASSERT(load(data) == network);
+
+    writeFile(data);
+    for (bool const verify : {true, false}) {
+        NetworkView const view(path, verify);
+        SHAREMIND_TESTASSERT(view.numInputs() == network.numInputs());
+        SHAREMIND_TESTASSERT(view.numStages() == network.numStages());
+        SHAREMIND_TESTASSERT(view.numComparators()
+                             == network.numComparators());
+        for (std::size_t i = 0u; i < network.numStages(); ++i)
+            SHAREMIND_TESTASSERT(view.numComparators(i)
+                                 == network.numComparators(i));
+        SHAREMIND_TESTASSERT(view.toNetwork() == network);
+
+        std::vector<std::int64_t> values(network.numInputs());
+        for (auto & value : values)
+            value = static_cast<std::int64_t>(rng() % 1000u);
+        auto expected(values);
+        network.sortValues(expected.data());
+        auto test(values);
+        view.sortValues(test.data());
+        SHAREMIND_TESTASSERT(test == expected);
+
+        expected = values;
+        network.sortValues(expected.begin(), std::greater<std::int64_t>());
+        test = values;
+        view.sortValues(test.begin(), std::greater<std::int64_t>());
+        SHAREMIND_TESTASSERT(test == expected);
+    }
+}
+
+void testInvalid() {
+    auto const data(save(Network::makeOddEvenMergeSort(20u)));
+
+    // Truncated data, including just the header:
+    for (std::size_t size : {std::size_t(0u),
+                             std::size_t(47u),
+                             std::size_t(48u),
+                             data.size() - 1u})
+    {
+        SHAREMIND_TESTASSERT(
+                throwsInvalidFormat([&]{ load(data.substr(0u, size)); }));
+        writeFile(data.substr(0u, size));
+        SHAREMIND_TESTASSERT(throwsInvalidFormat([]{ NetworkView v(path); }));
+    }
+
+    // Any corrupt byte in the header or the payload:
+    for (std::size_t i = 0u; i < data.size(); ++i) {
+        auto corrupt(data);
+        corrupt[i] = static_cast<char>(corrupt[i] ^ 0x10);
+        SHAREMIND_TESTASSERT(throwsInvalidFormat([&]{ load(corrupt); }));
+        writeFile(corrupt);
+        SHAREMIND_TESTASSERT(throwsInvalidFormat([]{ NetworkView v(path); }));
+    }
+
+    // Unverified views only check the header and sizes:
+    auto corrupt(data);
+    corrupt.back() = static_cast<char>(corrupt.back() ^ 0x01);
+    writeFile(corrupt);
+    SHAREMIND_TESTASSERT(throwsInvalidFormat([]{ NetworkView v(path); }));
+    NetworkView const view(path, false);
+    SHAREMIND_TESTASSERT(view.numInputs() == 20u);
+
+    std::remove(path.c_str());
+    bool thrown = false;
+    try {
+        NetworkView v(path);
+    } catch (std::system_error const &) {
+        thrown = true;
+    }
+    SHAREMIND_TESTASSERT(thrown);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::mt19937_64 rng(42u);
+    for (std::size_t n = 0u; n <= 40u; ++n) {
+        testRoundTrip(Network::makeOddEvenMergeSort(n), rng);
+        testRoundTrip(Network::makeBitonicMergeSort(n), rng);
+        testRoundTrip(Network::makePairwiseSort(n), rng);
+    }
+    testRoundTrip(Network::makeOddEvenMergeSort(1000u).normalized(), rng);
+
+    // Networks with empty stages and 32-bit line indexes:
+    Network network(70000u);
+    network.composeWithEmptyStage();
+    network.composeWith(Comparator(69999u, 0u));
+    network.composeWith(Comparator(65536u, 65537u));
+    network.composeWithEmptyStage();
+    network.composeWith(Comparator(1u, 69998u));
+    testRoundTrip(network, rng);
+    SHAREMIND_TESTASSERT(save(network).size()
+                         == 48u + (network.numStages() + 1u) * 8u + 3u * 8u);
+    SHAREMIND_TESTASSERT(save(Network::makeOddEvenMergeSort(4u)).size()
+                         == 48u + 4u * 8u + 5u * 4u);
+
+    testInvalid();
+    std::remove(path.c_str());
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/ParallelExecutor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <stdexcept>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::CompiledNetwork;
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::ParallelExecutor;
+
+struct TestException : std::runtime_error {
+    TestException() : std::runtime_error("TestException") {}
+};
+
+void testExecutor(ParallelExecutor & executor,
+                  Network const & net,
+                  CompiledNetwork const & compiled,
+                  std::mt19937_64 & rng)
+{
+    std::vector<std::int64_t> values(net.numInputs());
+    for (auto & value : values)
+        value = static_cast<std::int64_t>(rng() % 1000u);
+
+    auto expected(values);
+    net.sortValues(expected.data());
+    auto test(values);
+    executor.sortValues(compiled, test.data());
+    SHAREMIND_TESTASSERT(test == expected);
+
+    expected = values;
+    net.sortValues(expected.data(), std::greater<std::int64_t>());
+    test = values;
+    executor.sortValues(compiled,
+                        test.begin(),
+                        std::greater<std::int64_t>());
+    SHAREMIND_TESTASSERT(test == expected);
+}
+
+void testException(ParallelExecutor & executor,
+                   CompiledNetwork const & compiled)
+{
+    std::vector<int> values(compiled.numInputs(), 0);
+    bool caught = false;
+    try {
+        executor.sortValues(compiled,
+                            values.begin(),
+                            [](int const &, int const &) -> bool
+                            { throw TestException(); });
+    } catch (TestException const &) {
+        caught = true;
+    }
+    SHAREMIND_TESTASSERT(caught);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::mt19937_64 rng(42u);
+    {
+        ParallelExecutor const executor;
+        SHAREMIND_TESTASSERT(executor.numThreads() >= 1u);
+        SHAREMIND_TESTASSERT(executor.grainSize()
+                             == ParallelExecutor::defaultGrainSize);
+    }
+    for (std::size_t numThreads : {1u, 2u, 4u}) {
+        for (std::size_t grainSize : {1u, 7u, 64u}) {
+            ParallelExecutor executor(numThreads, grainSize);
+            SHAREMIND_TESTASSERT(executor.numThreads() == numThreads);
+            SHAREMIND_TESTASSERT(executor.grainSize() == grainSize);
+            for (std::size_t size : {0u, 1u, 2u, 7u, 33u, 100u, 1000u}) {
+                for (auto const & net : {Network::makeOddEvenMergeSort(size),
+                                         Network::makeBitonicMergeSort(size),
+                                         Network::makePairwiseSort(size)})
+                {
+                    CompiledNetwork const compiled(net);
+                    testExecutor(executor, net, compiled, rng);
+                    if (compiled.numComparators() > 0u)
+                        testException(executor, compiled);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/CompiledNetwork.h"
+#include "../src/Permutation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::CompiledNetwork;
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::computeInversePermutation;
+using sharemind::SortingNetwork::computePermutation;
+
+struct Record {
+    std::int32_t key;
+    std::uint32_t payload[15u];
+};
+
+bool operator<(Record const & lhs, Record const & rhs) noexcept
+{ return lhs.key < rhs.key; }
+
+template <typename NetworkType>
+void testPermutation(NetworkType const & net,
+                     std::vector<Record> const & records,
+                     std::vector<std::int32_t> const & keys,
+                     std::vector<std::int32_t> const & sortedKeys,
+                     std::vector<std::int32_t> const & reverseSortedKeys)
+{
+    auto const size = records.size();
+    auto const keyOf = [](Record const & r) { return r.key; };
+    auto const checkPermutation =
+            [&](std::vector<std::uint32_t> const & permutation,
+                std::vector<std::uint32_t> const & inverse,
+                std::vector<std::int32_t> const & expected)
+            {
+                for (std::size_t i = 0u; i < size; ++i) {
+                    SHAREMIND_TESTASSERT(permutation[i] < size);
+                    SHAREMIND_TESTASSERT(inverse[permutation[i]] == i);
+                    auto const & record = records[permutation[i]];
+                    SHAREMIND_TESTASSERT(record.key == expected[i]);
+                    SHAREMIND_TESTASSERT(record.payload[0u]
+                                         == permutation[i]);
+                }
+            };
+
+    std::vector<std::uint32_t> permutation(size);
+    std::vector<std::uint32_t> inverse(size);
+    computePermutation(net, records.begin(), permutation.begin(), keyOf);
+    computeInversePermutation(net, records.data(), inverse.data(), keyOf);
+    checkPermutation(permutation, inverse, sortedKeys);
+
+    computePermutation(net,
+                       records.begin(),
+                       permutation.data(),
+                       keyOf,
+                       std::greater<std::int32_t>());
+    computeInversePermutation(net,
+                              records.begin(),
+                              inverse.begin(),
+                              keyOf,
+                              std::greater<std::int32_t>());
+    checkPermutation(permutation, inverse, reverseSortedKeys);
+
+    computePermutation(net, records.begin(), permutation.begin());
+    computeInversePermutation(net, records.begin(), inverse.begin());
+    checkPermutation(permutation, inverse, sortedKeys);
+
+    std::vector<std::size_t> wideIndexes(size);
+    computePermutation(net, keys.begin(), wideIndexes.begin());
+    computeInversePermutation(net, keys.begin(), inverse.begin());
+    for (std::size_t i = 0u; i < size; ++i) {
+        SHAREMIND_TESTASSERT(keys[wideIndexes[i]] == sortedKeys[i]);
+        SHAREMIND_TESTASSERT(inverse[wideIndexes[i]] == i);
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    std::mt19937_64 rng(42u);
+    for (std::size_t size : {0u, 1u, 2u, 7u, 16u, 33u, 100u, 257u}) {
+        std::vector<Record> records(size);
+        std::vector<std::int32_t> keys(size);
+        for (std::size_t i = 0u; i < size; ++i) {
+            keys[i] = static_cast<std::int32_t>(rng() % 50u) - 25;
+            records[i].key = keys[i];
+            for (auto & p : records[i].payload)
+                p = static_cast<std::uint32_t>(i);
+        }
+        for (auto const & net : {Network::makeOddEvenMergeSort(size),
+                                 Network::makeBitonicMergeSort(size),
+                                 Network::makePairwiseSort(size)})
+        {
+            auto sortedKeys(keys);
+            net.sortValues(sortedKeys.data());
+            auto reverseSortedKeys(keys);
+            net.sortValues(reverseSortedKeys.data(),
+                           std::greater<std::int32_t>());
+            testPermutation(net, records, keys, sortedKeys, reverseSortedKeys);
+            testPermutation(CompiledNetwork(net),
+                            records,
+                            keys,
+                            sortedKeys,
+                            reverseSortedKeys);
+        }
+    }
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/Network.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Comparator;
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::Stage;
+
+/**
+  The reference implementation of Network::removeRedundantComparators() which
+  keeps only the comparators that swap their inputs for some 0-1 input:
+*/
+Network referenceWithoutRedundant(Network const & network) {
+    auto const n = network.numInputs();
+    std::vector<std::vector<bool> > swapping;
+    for (auto const & stage : network.stages())
+        swapping.emplace_back(stage.numComparators(), false);
+    std::vector<bool> values(n);
+    for (std::size_t pattern = 0u; pattern < (std::size_t(1u) << n);
+         ++pattern)
+    {
+        for (std::size_t i = 0u; i < n; ++i)
+            values[i] = ((pattern >> i) & 1u) != 0u;
+        for (std::size_t s = 0u; s < network.numStages(); ++s) {
+            auto const & comparators = network.stage(s).comparators();
+            for (std::size_t i = 0u; i < comparators.size(); ++i) {
+                auto const & c = comparators[i];
+                if (values[c.min()] && !values[c.max()]) {
+                    swapping[s][i] = true;
+                    values[c.min()] = false;
+                    values[c.max()] = true;
+                }
+            }
+        }
+    }
+    Network r(n);
+    for (std::size_t s = 0u; s < network.numStages(); ++s) {
+        Stage stage;
+        auto const & comparators = network.stage(s).comparators();
+        for (std::size_t i = 0u; i < comparators.size(); ++i)
+            if (swapping[s][i])
+                stage.addComparator(comparators[i]);
+        if (!stage.empty())
+            r.composeWith(std::move(stage));
+    }
+    r.compress();
+    return r;
+}
+
+bool haveSameOutputs(Network const & a,
+                     Network const & b,
+                     std::mt19937_64 & rng)
+{
+    std::vector<unsigned> values(a.numInputs());
+    for (unsigned round = 0u; round < 20u; ++round) {
+        for (auto & value : values)
+            value = static_cast<unsigned>(rng() % 16u);
+        auto valuesA(values);
+        auto valuesB(values);
+        a.sortValues(valuesA.begin());
+        b.sortValues(valuesB.begin());
+        if (valuesA != valuesB)
+            return false;
+    }
+    return true;
+}
+
+Network randomNetwork(std::size_t numInputs, std::mt19937_64 & rng) {
+    Network net(numInputs);
+    auto const numStages = rng() % 20u;
+    for (std::size_t s = 0u; s < numStages; ++s) {
+        Stage & stage = net.composeWithEmptyStage();
+        auto const tries = rng() % (numInputs + 1u);
+        for (std::size_t i = 0u; i < tries; ++i) {
+            Comparator const c(rng() % numInputs, rng() % numInputs);
+            if ((c.min() != c.max())
+                && (stage.getConflictsWith(c) == Stage::NoConflict))
+                stage.addComparator(c);
+        }
+    }
+    return net;
+}
+
+void testExact(std::mt19937_64 & rng) {
+    for (unsigned round = 0u; round < 500u; ++round) {
+        auto const net(randomNetwork(2u + rng() % 11u, rng));
+        auto const result(net.withoutRedundantComparators());
+        SHAREMIND_TESTASSERT(result == referenceWithoutRedundant(net));
+        SHAREMIND_TESTASSERT(result.numComparators() <= net.numComparators());
+        SHAREMIND_TESTASSERT(haveSameOutputs(net, result, rng));
+        SHAREMIND_TESTASSERT(result.withoutRedundantComparators() == result);
+    }
+
+    // Comparators implied by earlier ones:
+    Network net(3u);
+    net.composeWith(Comparator(0u, 1u));
+    net.composeWith(Comparator(1u, 2u));
+    net.composeWith(Comparator(0u, 1u));
+    net.composeWith(Comparator(0u, 2u));
+    net.composeWith(Comparator(1u, 2u));
+    net.removeRedundantComparators();
+    SHAREMIND_TESTASSERT(net.numComparators() == 3u);
+    SHAREMIND_TESTASSERT(net.isSortingNetwork());
+
+    // Networks derived from larger sorting networks:
+    for (std::size_t n = 9u; n < 16u; ++n) {
+        for (auto sorter : {Network::makeOddEvenMergeSort(16u),
+                            Network::makeBitonicMergeSort(16u),
+                            Network::makePairwiseSort(16u)})
+        {
+            while (sorter.numInputs() > n)
+                sorter.removeInput(sorter.numInputs() - 1u);
+            auto const result(sorter.withoutRedundantComparators());
+            SHAREMIND_TESTASSERT(result == referenceWithoutRedundant(sorter));
+            SHAREMIND_TESTASSERT(result.isSortingNetwork());
+        }
+    }
+    auto bitonic(Network::makeBitonicMergeSort(64u));
+    while (bitonic.numInputs() > 24u)
+        bitonic.removeInput(bitonic.numInputs() - 1u);
+    auto const numComparators = bitonic.numComparators();
+    bitonic.removeRedundantComparators();
+    SHAREMIND_TESTASSERT(bitonic.numComparators() < numComparators);
+    SHAREMIND_TESTASSERT(bitonic.isSortingNetwork());
+}
+
+void testLarge(std::mt19937_64 & rng) {
+    // Comparators implied by earlier ones:
+    Network net(100u);
+    for (std::size_t i = 0u; i + 1u < 100u; i += 2u)
+        net.composeWith(Comparator(i, i + 1u));
+    net.composeWith(Comparator(1u, 2u));
+    net.composeWith(Comparator(0u, 2u));
+    net.composeWith(Comparator(0u, 1u));
+    net.composeWith(Comparator(0u, 3u));
+    net.composeWith(Comparator(1u, 0u));
+    auto const result(net.withoutRedundantComparators());
+    SHAREMIND_TESTASSERT(result.numComparators() == 53u);
+    SHAREMIND_TESTASSERT(haveSameOutputs(net, result, rng));
+
+    for (std::size_t n : {100u, 1000u}) {
+        auto twice(Network::makeOddEvenMergeSort(n));
+        twice.composeWith(Network::makeOddEvenMergeSort(n));
+        auto const reduced(twice.withoutRedundantComparators());
+        SHAREMIND_TESTASSERT(reduced.numComparators()
+                             < twice.numComparators());
+        SHAREMIND_TESTASSERT(haveSameOutputs(twice, reduced, rng));
+    }
+
+    auto oddEven(Network::makeOddEvenMergeSort(128u));
+    while (oddEven.numInputs() > 100u)
+        oddEven.removeInput(oddEven.numInputs() - 1u);
+    auto const reduced(oddEven.withoutRedundantComparators());
+    SHAREMIND_TESTASSERT(reduced.numComparators() < oddEven.numComparators());
+    std::vector<unsigned> values(reduced.numInputs());
+    for (unsigned round = 0u; round < 20u; ++round) {
+        for (auto & value : values)
+            value = static_cast<unsigned>(rng());
+        reduced.sortValues(values.begin());
+        SHAREMIND_TESTASSERT(std::is_sorted(values.begin(), values.end()));
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    std::mt19937_64 rng(42u);
+    testExact(rng);
+    testLarge(rng);
+}
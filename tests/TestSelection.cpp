@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/Network.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Comparator;
+using sharemind::SortingNetwork::Network;
+
+std::vector<std::size_t> firstOutputs(std::size_t k) {
+    std::vector<std::size_t> r(k);
+    for (std::size_t i = 0u; i < k; ++i)
+        r[i] = i;
+    return r;
+}
+
+/** Checks the first k outputs for all 0-1-patterns, see the 0-1-principle: */
+bool selectsAllPatterns(Network const & network, std::size_t k) {
+    auto const n = network.numInputs();
+    std::vector<int> values(n);
+    for (std::uint64_t pattern = 0u; pattern < (std::uint64_t(1u) << n);
+         ++pattern)
+    {
+        std::size_t numZeros = 0u;
+        for (std::size_t i = 0u; i < n; ++i) {
+            values[i] = static_cast<int>((pattern >> i) & 1u);
+            numZeros += values[i] ? 0u : 1u;
+        }
+        network.sortValues(values.data());
+        for (std::size_t i = 0u; i < k; ++i)
+            if (values[i] != ((i < numZeros) ? 0 : 1))
+                return false;
+    }
+    return true;
+}
+
+bool selectsRandomValues(Network const & network,
+                         std::size_t k,
+                         std::mt19937_64 & rng)
+{
+    auto const n = network.numInputs();
+    std::vector<unsigned> values(n);
+    for (std::size_t round = 0u; round < 20u; ++round) {
+        for (auto & value : values)
+            value = static_cast<unsigned>(rng() % (n + 1u));
+        auto expected(values);
+        std::sort(expected.begin(), expected.end());
+        auto sorted(values);
+        network.sortValues(sorted.data());
+        if (!std::equal(expected.begin(),
+                        expected.begin() + static_cast<long>(k),
+                        sorted.begin()))
+            return false;
+        std::sort(sorted.begin(), sorted.end());
+        if (sorted != expected)
+            return false;
+    }
+    return true;
+}
+
+void testPruneToOutputs(std::mt19937_64 & rng) {
+    for (std::size_t n = 2u; n <= 20u; ++n) {
+        Network network(n);
+        for (std::size_t i = 0u; i < 3u * n; ++i) {
+            auto const a = static_cast<std::size_t>(rng() % n);
+            auto b = static_cast<std::size_t>(rng() % (n - 1u));
+            if (b >= a)
+                ++b;
+            network.composeWith(Comparator(a, b));
+        }
+        std::vector<std::size_t> outputs;
+        for (std::size_t i = 0u; i < n; ++i)
+            if (rng() % 3u == 0u)
+                outputs.emplace_back(i);
+        auto const pruned(network.prunedToOutputs(outputs));
+        SHAREMIND_TESTASSERT(pruned.numInputs() == n);
+        SHAREMIND_TESTASSERT(pruned.numComparators()
+                             <= network.numComparators());
+        for (auto const & stage : pruned.stages())
+            SHAREMIND_TESTASSERT(!stage.empty());
+        std::vector<unsigned> values(n);
+        for (std::size_t round = 0u; round < 20u; ++round) {
+            for (auto & value : values)
+                value = static_cast<unsigned>(rng() % 10u);
+            auto expected(values);
+            network.sortValues(expected.data());
+            pruned.sortValues(values.data());
+            for (auto const output : outputs)
+                SHAREMIND_TESTASSERT(values[output] == expected[output]);
+        }
+    }
+
+    auto const sorter(Network::makeOddEvenMergeSort(16u));
+    SHAREMIND_TESTASSERT(sorter.prunedToOutputs(firstOutputs(16u)) == sorter);
+    SHAREMIND_TESTASSERT(!sorter.prunedToOutputs({}).numStages());
+    auto const minimum(sorter.prunedToOutputs({0u}));
+    SHAREMIND_TESTASSERT(minimum.numComparators() == 15u);
+    SHAREMIND_TESTASSERT(selectsAllPatterns(minimum, 1u));
+    auto const median(sorter.prunedToOutputs({7u}));
+    SHAREMIND_TESTASSERT(median.numComparators() < sorter.numComparators());
+    std::vector<unsigned> values(16u);
+    for (std::size_t round = 0u; round < 100u; ++round) {
+        for (auto & value : values)
+            value = static_cast<unsigned>(rng() % 20u);
+        auto expected(values);
+        std::sort(expected.begin(), expected.end());
+        median.sortValues(values.data());
+        SHAREMIND_TESTASSERT(values[7u] == expected[7u]);
+    }
+}
+
+void testSelectionNetworks(std::mt19937_64 & rng) {
+    for (std::size_t n = 0u; n <= 16u; ++n) {
+        for (std::size_t k = 0u; k <= n + 1u; ++k) {
+            auto const network(Network::makeSelectionNetwork(n, k));
+            SHAREMIND_TESTASSERT(network.numInputs() == n);
+            SHAREMIND_TESTASSERT(selectsAllPatterns(network, std::min(k, n)));
+        }
+    }
+    for (std::size_t n : {33u, 100u, 1000u}) {
+        auto const sorter(Network::makeOddEvenMergeSort(n));
+        for (std::size_t k : {1u, 2u, 5u, 16u, 17u, 32u}) {
+            auto const network(Network::makeSelectionNetwork(n, k));
+            SHAREMIND_TESTASSERT(selectsRandomValues(network, k, rng));
+            SHAREMIND_TESTASSERT(
+                    network.numComparators()
+                    <= sorter.prunedToOutputs(firstOutputs(k))
+                             .numComparators());
+        }
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    std::mt19937_64 rng(42u);
+    testPruneToOutputs(rng);
+    testSelectionNetworks(rng);
+}
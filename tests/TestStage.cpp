@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/Stage.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <sharemind/TestAssert.h>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Comparator;
+using sharemind::SortingNetwork::Stage;
+
+constexpr std::size_t const numLines = 40u;
+
+/** Checks that the indexed stage answers all queries like the plain one: */
+void checkConflicts(Stage & indexed, Stage & plain) {
+    SHAREMIND_TESTASSERT(indexed.hasLineIndex());
+    SHAREMIND_TESTASSERT(!plain.hasLineIndex());
+    SHAREMIND_TESTASSERT(indexed == plain);
+    for (std::size_t a = 0u; a < numLines + 2u; ++a) {
+        for (std::size_t b = 0u; b < numLines + 2u; ++b) {
+            if (a == b)
+                continue;
+            Comparator const c(a, b);
+            SHAREMIND_TESTASSERT(indexed.getConflictsWith(c)
+                                 == plain.getConflictsWith(c));
+        }
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    std::mt19937_64 rng(42u);
+    for (unsigned round = 0u; round < 50u; ++round) {
+        Stage indexed;
+        indexed.buildLineIndex();
+        Stage plain;
+        for (unsigned i = 0u; i < 30u; ++i) {
+            Comparator const c(rng() % numLines, rng() % numLines);
+            if ((c.min() == c.max())
+                || (plain.getConflictsWith(c) != Stage::NoConflict))
+                continue;
+            indexed.addComparator(c);
+            plain.addComparator(c);
+        }
+        checkConflicts(indexed, plain);
+
+        {
+            auto comparators(plain.comparators());
+            std::shuffle(comparators.begin(), comparators.end(), rng);
+            SHAREMIND_TESTASSERT(Stage(std::move(comparators)) == plain);
+        }
+
+        indexed.invert();
+        plain.invert();
+        checkConflicts(indexed, plain);
+
+        indexed.swapIndexes(3u, numLines + 1u);
+        plain.swapIndexes(3u, numLines + 1u);
+        checkConflicts(indexed, plain);
+
+        indexed.removeInput(5u);
+        plain.removeInput(5u);
+        checkConflicts(indexed, plain);
+
+        indexed.shift(7u, numLines + 2u);
+        plain.shift(7u, numLines + 2u);
+        checkConflicts(indexed, plain);
+
+        while (!plain.empty()) {
+            auto const i = rng() % plain.numComparators();
+            indexed.removeComparator(i);
+            plain.removeComparator(i);
+            checkConflicts(indexed, plain);
+        }
+
+        Stage copy(indexed);
+        SHAREMIND_TESTASSERT(copy.hasLineIndex());
+        copy.clearLineIndex();
+        SHAREMIND_TESTASSERT(!copy.hasLineIndex());
+        indexed.clearLineIndex();
+        indexed.buildLineIndex();
+        checkConflicts(indexed, plain);
+    }
+}
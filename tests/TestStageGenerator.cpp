@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/Network.h"
+#include "../src/StageGenerator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Algorithm;
+using sharemind::SortingNetwork::BranchFreeExchange;
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::StageGenerator;
+
+void test(Algorithm algorithm, std::size_t numInputs, std::mt19937_64 & rng) {
+    StageGenerator const generator(algorithm, numInputs);
+    SHAREMIND_TESTASSERT(generator.algorithm() == algorithm);
+    SHAREMIND_TESTASSERT(generator.numInputs() == numInputs);
+    auto const expected(Network::make(algorithm, numInputs));
+
+    Network streamed(numInputs);
+    std::size_t numStages = 0u;
+    for (auto const & stage : generator) {
+        SHAREMIND_TESTASSERT(!stage.empty());
+        streamed.composeWith(stage);
+        ++numStages;
+    }
+    SHAREMIND_TESTASSERT(numStages == generator.numStages());
+    SHAREMIND_TESTASSERT(numStages >= expected.numStages());
+    if (!(numInputs & (numInputs - 1u))
+        || (algorithm == Algorithm::PairwiseSort))
+        SHAREMIND_TESTASSERT(numStages == expected.numStages());
+    SHAREMIND_TESTASSERT(streamed.compressed() == expected);
+
+    std::vector<std::int32_t> values(numInputs);
+    for (auto & value : values)
+        value = static_cast<std::int32_t>(rng() % 100u) - 50;
+    auto expectedValues(values);
+    expected.sortValues(expectedValues.data());
+    auto test(values);
+    generator.sortValues(test.data());
+    SHAREMIND_TESTASSERT(test == expectedValues);
+
+    expectedValues = values;
+    expected.sortValues(expectedValues.data(), std::greater<std::int32_t>());
+    test = values;
+    generator.sortValues(test.begin(), std::greater<std::int32_t>());
+    SHAREMIND_TESTASSERT(test == expectedValues);
+
+    expectedValues = values;
+    expected.sortValues(expectedValues.data());
+    test = values;
+    generator.sortValues(test.data(), BranchFreeExchange());
+    SHAREMIND_TESTASSERT(test == expectedValues);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::mt19937_64 rng(42u);
+    for (auto const algorithm : {Algorithm::OddEvenMergeSort,
+                                 Algorithm::BitonicMergeSort,
+                                 Algorithm::PairwiseSort})
+    {
+        for (std::size_t n = 0u; n <= 140u; ++n)
+            test(algorithm, n, rng);
+        for (std::size_t n : {255u, 256u, 1000u, 1024u, 3000u, 4096u})
+            test(algorithm, n, rng);
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/StaticNetwork.h"
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Algorithm;
+using sharemind::SortingNetwork::Network;
+using sharemind::SortingNetwork::StaticNetwork;
+
+static_assert(StaticNetwork<4u, Algorithm::OddEvenMergeSort>::numComparators
+              == 5u, "");
+static_assert(StaticNetwork<4u, Algorithm::OddEvenMergeSort>::numStages == 3u,
+              "");
+static_assert(StaticNetwork<8u, Algorithm::BitonicMergeSort>::numComparators
+              == 24u, "");
+static_assert(StaticNetwork<16u, Algorithm::OddEvenMergeSort>::comparator(0u)
+                    .max() == 1u, "");
+
+template <std::size_t N, Algorithm A>
+void testStaticNetwork() {
+    using SN = StaticNetwork<N, A>;
+    auto const expected(Network::make(A, N));
+    SHAREMIND_TESTASSERT(SN::numComparators == expected.numComparators());
+    SHAREMIND_TESTASSERT(SN::numStages == expected.numStages());
+    std::size_t i = 0u;
+    for (std::size_t s = 0u; s < expected.numStages(); ++s) {
+        SHAREMIND_TESTASSERT(SN::stageOffset(s) == i);
+        for (auto const & c : expected.stage(s).comparators()) {
+            SHAREMIND_TESTASSERT(SN::comparator(i).min() == c.min());
+            SHAREMIND_TESTASSERT(SN::comparator(i).max() == c.max());
+            ++i;
+        }
+    }
+    SHAREMIND_TESTASSERT(SN::stageOffset(SN::numStages) == i);
+    SHAREMIND_TESTASSERT(SN::makeNetwork() == expected);
+}
+
+template <std::size_t N, Algorithm A>
+void testSortValues(std::mt19937_64 & rng) {
+    using SN = StaticNetwork<N, A>;
+    auto const expected(Network::make(A, N));
+    for (unsigned round = 0u; round < 4u; ++round) {
+        std::vector<int> values(N);
+        for (auto & value : values)
+            value = static_cast<int>(rng() % 100u);
+        auto expectedValues(values);
+        expected.sortValues(expectedValues.data());
+        auto test(values);
+        SN::sortValues(test.begin());
+        SHAREMIND_TESTASSERT(test == expectedValues);
+
+        expectedValues = values;
+        expected.sortValues(expectedValues.data(), std::greater<int>());
+        test = values;
+        SN::sortValues(test.data(), std::greater<int>());
+        SHAREMIND_TESTASSERT(test == expectedValues);
+    }
+}
+
+template <std::size_t ... Ns>
+void testStaticNetworks(std::index_sequence<Ns...>) {
+    (void) std::initializer_list<int>{
+        (testStaticNetwork<Ns, Algorithm::OddEvenMergeSort>(),
+         testStaticNetwork<Ns, Algorithm::BitonicMergeSort>(),
+         testStaticNetwork<Ns, Algorithm::PairwiseSort>(),
+         0)...};
+}
+
+template <std::size_t ... Ns>
+void testSortValues(std::mt19937_64 & rng, std::index_sequence<Ns...>) {
+    (void) std::initializer_list<int>{
+        (testSortValues<Ns, Algorithm::OddEvenMergeSort>(rng),
+         testSortValues<Ns, Algorithm::BitonicMergeSort>(rng),
+         testSortValues<Ns, Algorithm::PairwiseSort>(rng),
+         0)...};
+}
+
+template <std::size_t ... Ns>
+using Sizes = std::index_sequence<Ns...>;
+
+} // anonymous namespace
+
+int main() {
+    testStaticNetworks(std::make_index_sequence<65u>());
+    std::mt19937_64 rng(42u);
+    testSortValues(rng, Sizes<0u, 1u, 2u, 3u, 4u, 5u, 8u, 13u, 16u, 33u, 64u>());
+}
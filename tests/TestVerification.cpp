@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) Cybernetica AS
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "../src/Network.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <sharemind/TestAssert.h>
+#include <vector>
+
+
+namespace {
+
+using sharemind::SortingNetwork::Comparator;
+using sharemind::SortingNetwork::Network;
+
+/** Tests all 0-1-patterns one by one: */
+bool referenceIsSortingNetwork(Network const & network) {
+    auto const n = network.numInputs();
+    std::vector<int> values(n);
+    for (std::uint64_t pattern = 0u; pattern < (std::uint64_t(1u) << n);
+         ++pattern)
+    {
+        for (std::size_t i = 0u; i < n; ++i)
+            values[i] = static_cast<int>((pattern >> i) & 1u);
+        network.sortValues(values.data());
+        if (!std::is_sorted(values.begin(), values.end()))
+            return false;
+    }
+    return true;
+}
+
+/** Tests all 0-1-patterns of two sorted sequences one by one: */
+bool referenceIsMergingNetwork(Network const & network,
+                               std::size_t n0,
+                               std::size_t n1)
+{
+    std::vector<int> values(n0 + n1);
+    for (std::size_t ones0 = 0u; ones0 <= n0; ++ones0) {
+        for (std::size_t ones1 = 0u; ones1 <= n1; ++ones1) {
+            for (std::size_t i = 0u; i < n0; ++i)
+                values[i] = (i >= n0 - ones0) ? 1 : 0;
+            for (std::size_t i = 0u; i < n1; ++i)
+                values[n0 + i] = (i >= n1 - ones1) ? 1 : 0;
+            network.sortValues(values.data());
+            if (!std::is_sorted(values.begin(), values.end()))
+                return false;
+        }
+    }
+    return true;
+}
+
+Network withoutComparator(Network const & network, std::size_t index) {
+    Network r(network.numInputs());
+    for (auto const & stage : network.stages()) {
+        auto & newStage = r.composeWithEmptyStage();
+        for (auto const & c : stage.comparators())
+            if (index-- != 0u)
+                newStage.addComparator(c);
+    }
+    return r;
+}
+
+Network randomNetwork(std::size_t n,
+                      std::size_t numComparators,
+                      std::mt19937_64 & rng)
+{
+    Network r(n);
+    for (std::size_t i = 0u; i < numComparators; ++i) {
+        auto const a = static_cast<std::size_t>(rng() % n);
+        auto b = static_cast<std::size_t>(rng() % (n - 1u));
+        if (b >= a)
+            ++b;
+        r.composeWith(Comparator(std::min(a, b), std::max(a, b)));
+    }
+    return r;
+}
+
+Comparator randomComparator(std::size_t n, std::mt19937_64 & rng) {
+    auto const a = static_cast<std::size_t>(rng() % n);
+    auto b = static_cast<std::size_t>(rng() % (n - 1u));
+    if (b >= a)
+        ++b;
+    return Comparator(a, b);
+}
+
+/** \returns a random network with comparators in both directions. */
+Network randomNonStandardNetwork(std::size_t n,
+                                 std::size_t numComparators,
+                                 std::mt19937_64 & rng)
+{
+    Network r(n);
+    for (std::size_t i = 0u; i < numComparators; ++i)
+        r.composeWith(randomComparator(n, rng));
+    return r;
+}
+
+/**
+  \returns a random network with comparators in both directions whose every
+           stage is equal to its reflection if exact is set, and equal to it
+           only up to the directions of the comparators otherwise.
+*/
+Network randomReflectedNetwork(std::size_t n,
+                               std::size_t numStages,
+                               bool exact,
+                               std::mt19937_64 & rng)
+{
+    Network r(n);
+    while (r.numStages() < numStages) {
+        auto const c(randomComparator(n, rng));
+        Comparator reflected(n - 1u - c.max(), n - 1u - c.min());
+        if (!exact && (rng() % 2u))
+            reflected.invert();
+        if (reflected.left() == c.left()) {
+            // A comparator on lines i and n - 1 - i is its own reflection:
+            r.composeWithEmptyStage().addComparator(c);
+        } else if (reflected.left() != c.right()
+                   && reflected.right() != c.left()
+                   && reflected.right() != c.right())
+        {
+            auto & stage = r.composeWithEmptyStage();
+            stage.addComparator(c);
+            stage.addComparator(reflected);
+        }
+    }
+    return r;
+}
+
+void testBruteForce(std::mt19937_64 & rng) {
+    for (std::size_t n = 0u; n <= 12u; ++n) {
+        for (auto const & network : {Network::makeOddEvenMergeSort(n),
+                                     Network::makeBitonicMergeSort(n),
+                                     Network::makePairwiseSort(n)})
+        {
+            SHAREMIND_TESTASSERT(network.bruteForceIsSortingNetwork());
+            SHAREMIND_TESTASSERT(network.bruteForceIsSortingNetwork(1u));
+            for (std::size_t i = 0u; i < network.numComparators(); ++i) {
+                auto const pruned(withoutComparator(network, i));
+                SHAREMIND_TESTASSERT(pruned.bruteForceIsSortingNetwork()
+                                     == referenceIsSortingNetwork(pruned));
+            }
+        }
+        if (n >= 2u) {
+            for (std::size_t i = 0u; i < 20u; ++i) {
+                auto const network(randomNetwork(n, n * n, rng));
+                SHAREMIND_TESTASSERT(network.bruteForceIsSortingNetwork()
+                                     == referenceIsSortingNetwork(network));
+            }
+        }
+    }
+
+    // Larger networks, split between several threads:
+    for (std::size_t n : {20u, 23u}) {
+        auto const network(Network::makeOddEvenMergeSort(n));
+        SHAREMIND_TESTASSERT(network.bruteForceIsSortingNetwork(1u));
+        SHAREMIND_TESTASSERT(network.bruteForceIsSortingNetwork(4u));
+        for (std::size_t i : {std::size_t(0u),
+                              network.numComparators() / 2u,
+                              network.numComparators() - 1u})
+        {
+            auto const pruned(withoutComparator(network, i));
+            SHAREMIND_TESTASSERT(!pruned.bruteForceIsSortingNetwork(1u));
+            SHAREMIND_TESTASSERT(!pruned.bruteForceIsSortingNetwork(4u));
+        }
+    }
+}
+
+void testPrefixSet(std::mt19937_64 & rng) {
+    for (std::size_t n = 0u; n <= 12u; ++n) {
+        for (auto const & network : {Network::makeOddEvenMergeSort(n),
+                                     Network::makeBitonicMergeSort(n),
+                                     Network::makePairwiseSort(n)})
+        {
+            SHAREMIND_TESTASSERT(network.isSortingNetwork());
+            SHAREMIND_TESTASSERT(network.isSortingNetwork(16u));
+            for (std::size_t i = 0u; i < network.numComparators(); ++i) {
+                auto const pruned(withoutComparator(network, i));
+                auto const expected = pruned.bruteForceIsSortingNetwork(1u);
+                SHAREMIND_TESTASSERT(pruned.isSortingNetwork() == expected);
+                SHAREMIND_TESTASSERT(pruned.isSortingNetwork(16u) == expected);
+                SHAREMIND_TESTASSERT(pruned.isSortingNetwork(1u) == expected);
+            }
+        }
+        if (n >= 2u) {
+            for (std::size_t i = 0u; i < 20u; ++i) {
+                auto const network(randomNetwork(n, n * n, rng));
+                auto const expected = network.bruteForceIsSortingNetwork(1u);
+                SHAREMIND_TESTASSERT(network.isSortingNetwork() == expected);
+                SHAREMIND_TESTASSERT(network.isSortingNetwork(16u) == expected);
+            }
+        }
+    }
+
+    // Comparators in both directions, with and without reflection symmetry:
+    for (std::size_t n = 2u; n <= 8u; ++n) {
+        for (std::size_t i = 0u; i < 200u; ++i) {
+            for (auto const & network :
+                 {randomNonStandardNetwork(n, n * n, rng),
+                  randomReflectedNetwork(n, n * n / 2u, true, rng),
+                  randomReflectedNetwork(n, n * n / 2u, false, rng)})
+            {
+                auto const expected = referenceIsSortingNetwork(network);
+                SHAREMIND_TESTASSERT(network.isSortingNetwork() == expected);
+                SHAREMIND_TESTASSERT(network.isSortingNetwork(16u) == expected);
+            }
+        }
+    }
+    {
+        // Equal to its reflection only up to the directions of comparators:
+        Network network(4u);
+        for (auto const & stage : {std::vector<Comparator>{{1u, 0u}, {3u, 2u}},
+                                   std::vector<Comparator>{{0u, 2u}, {1u, 3u}},
+                                   std::vector<Comparator>{{0u, 3u}},
+                                   std::vector<Comparator>{{0u, 1u}, {2u, 3u}},
+                                   std::vector<Comparator>{{1u, 0u}, {2u, 3u}},
+                                   std::vector<Comparator>{{1u, 2u}}})
+        {
+            auto & newStage = network.composeWithEmptyStage();
+            for (auto const & c : stage)
+                newStage.addComparator(c);
+        }
+        SHAREMIND_TESTASSERT(!referenceIsSortingNetwork(network));
+        SHAREMIND_TESTASSERT(!network.bruteForceIsSortingNetwork());
+        SHAREMIND_TESTASSERT(!network.isSortingNetwork());
+    }
+
+    // Larger networks, with and without reflection symmetry:
+    for (std::size_t n : {24u, 32u, 40u}) {
+        for (auto const & network : {Network::makeOddEvenMergeSort(n),
+                                     Network::makeBitonicMergeSort(n),
+                                     Network::makePairwiseSort(n)})
+        {
+            SHAREMIND_TESTASSERT(network.isSortingNetwork());
+            auto reduced(network);
+            reduced.removeInput(n - 1u);
+            SHAREMIND_TESTASSERT(reduced.isSortingNetwork());
+            for (std::size_t i : {std::size_t(0u),
+                                  network.numComparators() / 2u,
+                                  network.numComparators() - 1u})
+                SHAREMIND_TESTASSERT(
+                        !withoutComparator(network, i).isSortingNetwork());
+        }
+    }
+    SHAREMIND_TESTASSERT(
+            Network::makeOddEvenMergeSort(24u).isSortingNetwork(1024u));
+    SHAREMIND_TESTASSERT(!Network(3u).isSortingNetwork());
+    SHAREMIND_TESTASSERT(Network::makeBitonicMergeSort(64u).isSortingNetwork());
+}
+
+void testMerging(std::mt19937_64 & rng) {
+    for (std::size_t n0 = 0u; n0 <= 12u; ++n0) {
+        for (std::size_t n1 = 0u; n1 <= 12u; ++n1) {
+            auto const merger(combineOddEvenMerge(Network(n0), Network(n1)));
+            SHAREMIND_TESTASSERT(isMergingNetwork(merger, n0, n1));
+            SHAREMIND_TESTASSERT(isMergingNetwork(merger, n0, n1, 1u));
+            for (std::size_t i = 0u; i < merger.numComparators(); ++i) {
+                auto const pruned(withoutComparator(merger, i));
+                SHAREMIND_TESTASSERT(
+                        isMergingNetwork(pruned, n0, n1)
+                        == referenceIsMergingNetwork(pruned, n0, n1));
+            }
+            if (n0 + n1 >= 2u) {
+                auto const network(randomNetwork(n0 + n1, n0 + n1, rng));
+                SHAREMIND_TESTASSERT(
+                        isMergingNetwork(network, n0, n1)
+                        == referenceIsMergingNetwork(network, n0, n1));
+            }
+        }
+    }
+    for (std::size_t n : {2u, 4u, 8u, 16u}) {
+        auto const merger(combineBitonicMerge(Network(n), Network(n)));
+        SHAREMIND_TESTASSERT(isMergingNetwork(merger, n, n)
+                             == referenceIsMergingNetwork(merger, n, n));
+        SHAREMIND_TESTASSERT(
+                isMergingNetwork(combineBitonicMerge(
+                                     Network::makeBitonicMergeSort(n),
+                                     Network::makeBitonicMergeSort(n)),
+                                 n,
+                                 n));
+    }
+
+    // Mergers with thousands of inputs, split between several threads:
+    for (std::size_t n0 : {1000u, 1024u}) {
+        std::size_t const n1 = 1500u;
+        auto const merger(combineOddEvenMerge(Network(n0), Network(n1)));
+        SHAREMIND_TESTASSERT(isMergingNetwork(merger, n0, n1, 1u));
+        SHAREMIND_TESTASSERT(isMergingNetwork(merger, n0, n1, 4u));
+        for (std::size_t i : {std::size_t(0u),
+                              merger.numComparators() / 2u,
+                              merger.numComparators() - 1u})
+            SHAREMIND_TESTASSERT(
+                    !isMergingNetwork(withoutComparator(merger, i), n0, n1));
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    std::mt19937_64 rng(42u);
+    testBruteForce(rng);
+    testPrefixSet(rng);
+    testMerging(rng);
+}